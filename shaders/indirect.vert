@@ -0,0 +1,30 @@
+#version 450
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+struct InstanceData {
+    mat4 model;
+    vec4 tint;
+};
+
+// one entry per object, the indirect command's firstInstance selects it
+layout(std430, binding = 2) readonly buffer ObjectBuffer {
+    InstanceData objects[];
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+    InstanceData object = objects[gl_InstanceIndex];
+    gl_Position = ubo.proj * ubo.view * object.model * vec4(inPosition, 1.0);
+    fragColor = inColor * object.tint.rgb;
+    fragTexCoord = inTexCoord;
+}
@@ -7,5 +7,6 @@ layout(location = 0) out vec4 outColor;
 layout(binding = 1) uniform sampler2D texSampler;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
+    // fragColor carries the vertex color times the per-object tint
+    outColor = texture(texSampler, fragTexCoord) * vec4(fragColor, 1.0);
 }
\ No newline at end of file
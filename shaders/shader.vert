@@ -1,12 +1,21 @@
 #version 450
 
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
     mat4 view;
     mat4 proj;
 } ubo;
 
-layout(location = 0) in vec2 inPosition;
+// per draw, DrawConstants in vulkan_app.h
+layout(push_constant) uniform DrawConstants {
+    mat4 model;
+    uint material;
+} draw;
+
+// material index -> tint, the palette of object_tint() in vulkan_app.cpp
+const vec3 tints[4] = vec3[](vec3(1.0, 1.0, 1.0), vec3(1.0, 0.6, 0.6),
+                             vec3(0.6, 1.0, 0.6), vec3(0.6, 0.6, 1.0));
+
+layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 
@@ -14,7 +23,7 @@ layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
+    gl_Position = ubo.proj * ubo.view * draw.model * vec4(inPosition, 1.0);
+    fragColor = inColor * tints[draw.material];
     fragTexCoord = inTexCoord;
-}
\ No newline at end of file
+}
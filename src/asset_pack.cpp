@@ -0,0 +1,252 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "asset_pack.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "image_util.h"
+#include "ktx2.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char PACK_MAGIC[4] = {'V', 'K', 'P', 'K'};
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint64_t mesh_index_offset(MeshBlob const &mesh) {
+    return align_up(
+        sizeof(MeshBlob) + (uint64_t)mesh.vertex_count * mesh.vertex_stride,
+        4);
+}
+
+void AssetPack::open(std::string const &path) {
+    close();
+#ifdef _WIN32
+    auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open asset pack! " + path);
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    auto mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+                         : nullptr;
+    file_handle = file;
+    mapping_handle = mapping;
+    if (!view) {
+        close();
+        throw std::runtime_error("failed to map asset pack! " + path);
+    }
+    base = static_cast<unsigned char const *>(view);
+    size = (uint64_t)file_size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open asset pack! " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("failed to stat asset pack! " + path);
+    }
+    void *view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE,
+                      fd, 0);
+    ::close(fd);  // the mapping keeps the file alive
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("failed to map asset pack! " + path);
+    }
+    // start paging in right away, the first lookups follow shortly
+    madvise(view, (size_t)info.st_size, MADV_WILLNEED);
+    base = static_cast<unsigned char const *>(view);
+    size = (uint64_t)info.st_size;
+#endif
+
+    PackHeader header;
+    if (size < sizeof(header)) {
+        close();
+        throw std::runtime_error("asset pack is truncated! " + path);
+    }
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 ||
+        header.version != VERSION || header.file_size != size ||
+        header.toc_offset + (uint64_t)header.entry_count * sizeof(PackEntry) >
+            size) {
+        close();
+        throw std::runtime_error("invalid asset pack header! " + path);
+    }
+    toc.resize(header.entry_count);
+    memcpy(toc.data(), base + header.toc_offset,
+           toc.size() * sizeof(PackEntry));
+    for (auto &entry : toc) {
+        entry.name[sizeof(entry.name) - 1] = '\0';
+        if (entry.offset + entry.size > size) {
+            close();
+            throw std::runtime_error("asset pack entry out of bounds! " +
+                                     path);
+        }
+    }
+}
+
+void AssetPack::close() {
+    if (base) {
+#ifdef _WIN32
+        UnmapViewOfFile(base);
+#else
+        munmap(const_cast<unsigned char *>(base), (size_t)size);
+#endif
+    }
+#ifdef _WIN32
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle) {
+        CloseHandle(file_handle);
+    }
+    file_handle = mapping_handle = nullptr;
+#endif
+    base = nullptr;
+    size = 0;
+    toc.clear();
+}
+
+AssetView AssetPack::find(std::string const &name, AssetType type) const {
+    for (auto const &entry : toc) {
+        if (entry.type == (uint32_t)type && name == entry.name) {
+            return AssetView{.data = base + entry.offset,
+                             .size = (size_t)entry.size};
+        }
+    }
+    return {};
+}
+
+MeshView AssetPack::mesh(std::string const &name) const {
+    auto view = find(name, ASSET_MESH);
+    MeshView mesh;
+    if (view.size < sizeof(MeshBlob)) {
+        return mesh;
+    }
+    memcpy(&mesh.header, view.data, sizeof(MeshBlob));
+    auto index_offset = mesh_index_offset(mesh.header);
+    if (index_offset + (uint64_t)mesh.header.index_count *
+                           mesh.header.index_size >
+        view.size) {
+        throw std::runtime_error("asset pack mesh is truncated! " + name);
+    }
+    auto bytes = static_cast<unsigned char const *>(view.data);
+    mesh.vertices = bytes + sizeof(MeshBlob);
+    mesh.indices = bytes + index_offset;
+    return mesh;
+}
+
+TextureView AssetPack::texture(std::string const &name) const {
+    auto view = find(name, ASSET_TEXTURE);
+    TextureView texture;
+    if (view.size < sizeof(TextureBlob)) {
+        return texture;
+    }
+    memcpy(&texture.header, view.data, sizeof(TextureBlob));
+    // level sizes divide by the block extent, so the header has to be sane
+    // before anyone computes them
+    auto const &header = texture.header;
+    uint32_t block_extent, block_bytes;
+    if (!ktx2_block_info((VkFormat)header.format, block_extent,
+                         block_bytes) ||
+        header.block_extent != block_extent ||
+        header.block_bytes != block_bytes || header.width == 0 ||
+        header.height == 0 || header.mip_levels == 0 ||
+        header.mip_levels > mip_level_count(header.width, header.height)) {
+        throw std::runtime_error("invalid asset pack texture header! " + name);
+    }
+    texture.levels = static_cast<unsigned char const *>(view.data) +
+                     sizeof(TextureBlob);
+    texture.size = view.size - sizeof(TextureBlob);
+    return texture;
+}
+
+PackBlob make_mesh_blob(std::string name, void const *vertices,
+                        uint32_t vertex_count, uint32_t vertex_stride,
+                        void const *indices, uint32_t index_count,
+                        uint32_t index_size) {
+    MeshBlob header{.vertex_count = vertex_count,
+                    .vertex_stride = vertex_stride,
+                    .index_count = index_count,
+                    .index_size = index_size};
+    auto index_offset = mesh_index_offset(header);
+    PackBlob blob{.name = std::move(name), .type = ASSET_MESH};
+    blob.data.resize(index_offset + (size_t)index_count * index_size);
+    memcpy(blob.data.data(), &header, sizeof(header));
+    memcpy(blob.data.data() + sizeof(header), vertices,
+           (size_t)vertex_count * vertex_stride);
+    memcpy(blob.data.data() + index_offset, indices,
+           (size_t)index_count * index_size);
+    return blob;
+}
+
+PackBlob make_texture_blob(std::string name, TextureBlob const &header,
+                           void const *levels, size_t size) {
+    PackBlob blob{.name = std::move(name), .type = ASSET_TEXTURE};
+    blob.data.resize(sizeof(header) + size);
+    memcpy(blob.data.data(), &header, sizeof(header));
+    memcpy(blob.data.data() + sizeof(header), levels, size);
+    return blob;
+}
+
+void write_asset_pack(std::string const &path,
+                      std::vector<PackBlob> const &blobs) {
+    std::vector<PackEntry> toc(blobs.size());
+    uint64_t offset = sizeof(PackHeader);
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        if (blobs[i].name.size() >= sizeof(toc[i].name)) {
+            throw std::runtime_error("asset name is too long! " +
+                                     blobs[i].name);
+        }
+        memcpy(toc[i].name, blobs[i].name.c_str(), blobs[i].name.size() + 1);
+        toc[i].type = blobs[i].type;
+        offset = align_up(offset, AssetPack::PACK_ALIGNMENT);
+        toc[i].offset = offset;
+        toc[i].size = blobs[i].data.size();
+        offset += toc[i].size;
+    }
+    PackHeader header{.version = AssetPack::VERSION,
+                      .entry_count = (uint32_t)toc.size(),
+                      .toc_offset = align_up(offset, 8)};
+    memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.file_size = header.toc_offset + toc.size() * sizeof(PackEntry);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open asset pack output! " + path);
+    }
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    auto pad_to = [&](uint64_t position) {
+        while ((uint64_t)file.tellp() < position) {
+            file.put(0);
+        }
+    };
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        pad_to(toc[i].offset);
+        file.write(reinterpret_cast<char const *>(blobs[i].data.data()),
+                   (std::streamsize)blobs[i].data.size());
+    }
+    pad_to(header.toc_offset);
+    file.write(reinterpret_cast<char const *>(toc.data()),
+               toc.size() * sizeof(PackEntry));
+    if (!file) {
+        throw std::runtime_error("failed to write asset pack! " + path);
+    }
+}
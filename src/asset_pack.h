@@ -0,0 +1,128 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_ASSET_PACK_H
+#define VK_TUTORIAL_ASSET_PACK_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+typedef enum AssetType {
+    ASSET_MESH = 1,
+    ASSET_TEXTURE = 2,
+    ASSET_SHADER = 3,  // SPIR-V words
+} AssetType;
+
+// On disk layout, all little endian:
+//   PackHeader | blobs, each PACK_ALIGNMENT aligned | PackEntry[entry_count]
+// Mesh blobs start with a MeshBlob followed by the vertices and then the
+// indices, texture blobs with a TextureBlob followed by every level packed
+// largest first, i.e. exactly what StagingUploader::upload_image expects.
+typedef struct PackHeader {
+    char magic[4];  // "VKPK"
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+    uint64_t toc_offset;
+    uint64_t file_size;
+} PackHeader;
+
+typedef struct PackEntry {
+    char name[40];  // NUL terminated, usually the original relative path
+    uint32_t type;  // AssetType
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+} PackEntry;
+
+typedef struct MeshBlob {
+    uint32_t vertex_count;
+    uint32_t vertex_stride;
+    uint32_t index_count;
+    uint32_t index_size;  // 2 or 4 bytes
+} MeshBlob;
+
+typedef struct TextureBlob {
+    uint32_t format;  // VkFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_levels;
+    uint32_t block_extent;
+    uint32_t block_bytes;
+    uint32_t reserved[2];
+} TextureBlob;
+
+// A read only window into the mapped file, valid until the pack is closed.
+typedef struct AssetView {
+    void const *data{nullptr};
+    size_t size{0};
+} AssetView;
+
+typedef struct MeshView {
+    MeshBlob header{};
+    void const *vertices{nullptr};
+    void const *indices{nullptr};
+} MeshView;
+
+typedef struct TextureView {
+    TextureBlob header{};
+    void const *levels{nullptr};
+    size_t size{0};
+} TextureView;
+
+// A blob to be written by write_asset_pack, data is copied verbatim.
+typedef struct PackBlob {
+    std::string name;
+    AssetType type;
+    std::vector<unsigned char> data;
+} PackBlob;
+
+// Memory maps a pack file once, lookups hand out pointers into the mapping
+// so assets can be memcpy'd straight into staging memory without an
+// intermediate read buffer. The mapping is shared, lookups are thread safe.
+class AssetPack {
+   public:
+    static const uint32_t VERSION = 1;
+    static const uint64_t PACK_ALIGNMENT = 256;
+
+    AssetPack() = default;
+    AssetPack(AssetPack const &) = delete;
+    AssetPack &operator=(AssetPack const &) = delete;
+    ~AssetPack() { close(); }
+
+    void open(std::string const &path);
+    void close();
+    bool is_open() const { return base != nullptr; }
+
+    // empty views when the name is missing or has another type
+    AssetView find(std::string const &name, AssetType type) const;
+    // these throw when the blob header is inconsistent with its contents
+    MeshView mesh(std::string const &name) const;
+    TextureView texture(std::string const &name) const;
+    std::vector<PackEntry> const &entries() const { return toc; }
+    uint64_t mapped_size() const { return size; }
+
+   private:
+    unsigned char const *base{nullptr};
+    uint64_t size{0};
+    std::vector<PackEntry> toc;
+#ifdef _WIN32
+    void *file_handle{nullptr};
+    void *mapping_handle{nullptr};
+#endif
+};
+
+PackBlob make_mesh_blob(std::string name, void const *vertices,
+                        uint32_t vertex_count, uint32_t vertex_stride,
+                        void const *indices, uint32_t index_count,
+                        uint32_t index_size);
+PackBlob make_texture_blob(std::string name, TextureBlob const &header,
+                           void const *levels, size_t size);
+void write_asset_pack(std::string const &path,
+                      std::vector<PackBlob> const &blobs);
+
+#endif  // VK_TUTORIAL_ASSET_PACK_H
@@ -0,0 +1,163 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "command_recycler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+void CommandRecycler::init(VkDevice device, VkQueue queue,
+                           uint32_t queue_family, uint32_t capacity) {
+    this->device = device;
+    this->queue = queue;
+    this->queue_family = queue_family;
+    this->capacity = std::max(capacity, 1u);
+
+    VkCommandPoolCreateInfo pool_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+                 VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queue_family};
+    if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to create one-time command pool!");
+    }
+}
+
+void CommandRecycler::destroy() {
+    while (!in_flight.empty()) {
+        collect(true);
+    }
+    for (auto &slot : slots) {
+        vkDestroyFence(device, slot.fence, nullptr);
+    }
+    slots.clear();
+    free_slots.clear();
+    // frees every command buffer allocated from it
+    vkDestroyCommandPool(device, command_pool, nullptr);
+    command_pool = VK_NULL_HANDLE;
+}
+
+void CommandRecycler::collect(bool wait_oldest) {
+    if (wait_oldest && !in_flight.empty()) {
+        vkWaitForFences(device, 1, &slots[in_flight.front()].fence, VK_TRUE,
+                        UINT64_MAX);
+    }
+    while (!in_flight.empty()) {
+        auto slot = in_flight.front();
+        if (vkGetFenceStatus(device, slots[slot].fence) != VK_SUCCESS) {
+            break;
+        }
+        in_flight.pop_front();
+        free_slots.push_back(slot);
+    }
+    counters.in_flight = (uint32_t)in_flight.size();
+}
+
+VkCommandBuffer CommandRecycler::begin() {
+    collect(false);
+
+    uint32_t slot;
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+        ++counters.reused;
+    } else if (slots.size() < capacity) {
+        Slot new_slot;
+        VkCommandBufferAllocateInfo alloc_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = command_pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1};
+        if (vkAllocateCommandBuffers(device, &alloc_info,
+                                     &new_slot.command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error(
+                "failed to allocate one-time command buffer!");
+        }
+        VkFenceCreateInfo fence_info{
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        if (vkCreateFence(device, &fence_info, nullptr, &new_slot.fence) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create one-time fence!");
+        }
+        slots.push_back(new_slot);
+        slot = (uint32_t)slots.size() - 1;
+        ++counters.allocated;
+    } else {
+        // at capacity, wait for the oldest submission instead of growing
+        ++counters.capacity_waits;
+        collect(true);
+        slot = free_slots.back();
+        free_slots.pop_back();
+        ++counters.reused;
+    }
+
+    auto command_buffer = slots[slot].command_buffer;
+    vkResetCommandBuffer(command_buffer, 0);
+    VkCommandBufferBeginInfo begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin one-time command buffer!");
+    }
+    return command_buffer;
+}
+
+uint32_t CommandRecycler::slot_of(VkCommandBuffer command_buffer) const {
+    for (uint32_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].command_buffer == command_buffer) {
+            return i;
+        }
+    }
+    throw std::runtime_error("command buffer not owned by this recycler!");
+}
+
+void CommandRecycler::end_and_submit(uint32_t slot, VkSemaphore wait_timeline,
+                                     uint64_t wait_value,
+                                     VkPipelineStageFlags wait_stage) {
+    auto &entry = slots[slot];
+    vkEndCommandBuffer(entry.command_buffer);
+    vkResetFences(device, 1, &entry.fence);
+
+    uint32_t wait_count = wait_timeline != VK_NULL_HANDLE ? 1 : 0;
+    VkTimelineSemaphoreSubmitInfo timeline_info{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount = wait_count,
+        .pWaitSemaphoreValues = &wait_value};
+    VkSubmitInfo submit_info{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                             .pNext = &timeline_info,
+                             .waitSemaphoreCount = wait_count,
+                             .pWaitSemaphores = &wait_timeline,
+                             .pWaitDstStageMask = &wait_stage,
+                             .commandBufferCount = 1,
+                             .pCommandBuffers = &entry.command_buffer};
+    if (vkQueueSubmit(queue, 1, &submit_info, entry.fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit one-time command buffer!");
+    }
+    in_flight.push_back(slot);
+    ++counters.submissions;
+    counters.in_flight = (uint32_t)in_flight.size();
+    counters.peak_in_flight =
+        std::max(counters.peak_in_flight, counters.in_flight);
+}
+
+void CommandRecycler::submit(VkCommandBuffer command_buffer,
+                             VkSemaphore wait_timeline, uint64_t wait_value,
+                             VkPipelineStageFlags wait_stage) {
+    end_and_submit(slot_of(command_buffer), wait_timeline, wait_value,
+                   wait_stage);
+}
+
+void CommandRecycler::submit_and_wait(VkCommandBuffer command_buffer) {
+    auto slot = slot_of(command_buffer);
+    end_and_submit(slot, VK_NULL_HANDLE, 0, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    vkWaitForFences(device, 1, &slots[slot].fence, VK_TRUE, UINT64_MAX);
+    collect(false);
+}
+
+void CommandRecycler::print_stats(std::ostream &os) const {
+    os << "one-time commands: " << counters.submissions << " submissions, "
+       << counters.allocated << " buffers allocated, " << counters.reused
+       << " reused, peak " << counters.peak_in_flight << " in flight, "
+       << counters.capacity_waits << " capacity waits\n";
+}
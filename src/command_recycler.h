@@ -0,0 +1,74 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_COMMAND_RECYCLER_H
+#define VK_TUTORIAL_COMMAND_RECYCLER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <vector>
+
+typedef struct CommandRecyclerStats {
+    uint32_t allocated{0};    // command buffers ever allocated (<= capacity)
+    uint64_t reused{0};       // begin() calls served from the free list
+    uint64_t submissions{0};
+    uint32_t in_flight{0};
+    uint32_t peak_in_flight{0};
+    uint64_t capacity_waits{0};  // begin() had to wait for the GPU
+} CommandRecyclerStats;
+
+// Hands out one-time-submit command buffers for a single queue. Buffers and
+// their fences are recycled once the GPU is done with them instead of being
+// allocated and freed per use, and the total count is capped so command
+// buffer memory stays bounded.
+class CommandRecycler {
+   public:
+    static const uint32_t DEFAULT_CAPACITY = 16;
+
+    void init(VkDevice device, VkQueue queue, uint32_t queue_family,
+              uint32_t capacity = DEFAULT_CAPACITY);
+    void destroy();
+
+    // returns a command buffer in the recording state
+    VkCommandBuffer begin();
+    // end and submit, the buffer returns to the free list once it finished;
+    // optionally waits on a timeline semaphore value (e.g. an upload ticket)
+    void submit(VkCommandBuffer command_buffer,
+                VkSemaphore wait_timeline = VK_NULL_HANDLE,
+                uint64_t wait_value = 0,
+                VkPipelineStageFlags wait_stage =
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    // same as submit, then block on this buffer's fence (not the queue)
+    void submit_and_wait(VkCommandBuffer command_buffer);
+
+    CommandRecyclerStats stats() const { return counters; }
+    uint32_t family() const { return queue_family; }
+    void print_stats(std::ostream &os) const;
+
+   private:
+    typedef struct Slot {
+        VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+        VkFence fence{VK_NULL_HANDLE};
+    } Slot;
+
+    VkDevice device{VK_NULL_HANDLE};
+    VkQueue queue{VK_NULL_HANDLE};
+    uint32_t queue_family{0};
+    VkCommandPool command_pool{VK_NULL_HANDLE};
+    uint32_t capacity{DEFAULT_CAPACITY};
+    std::vector<Slot> slots;
+    std::vector<uint32_t> free_slots;
+    std::deque<uint32_t> in_flight;  // submission order
+    CommandRecyclerStats counters;
+
+    uint32_t slot_of(VkCommandBuffer command_buffer) const;
+    void collect(bool wait_oldest);
+    void end_and_submit(uint32_t slot, VkSemaphore wait_timeline,
+                        uint64_t wait_value, VkPipelineStageFlags wait_stage);
+};
+
+#endif  // VK_TUTORIAL_COMMAND_RECYCLER_H
@@ -0,0 +1,97 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "cpu_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+std::atomic<bool> CpuTrace::enabled{false};
+
+typedef struct ThreadRing {
+    std::unique_ptr<TraceEvent[]> events{
+        new TraceEvent[CpuTrace::RING_CAPACITY]};
+    std::atomic<uint64_t> written{0};  // total events, ring index = % capacity
+    uint32_t tid{0};
+    std::string name;
+} ThreadRing;
+
+// rings outlive their threads so a dump still sees finished workers
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<ThreadRing>> registry;
+static thread_local ThreadRing *local_ring = nullptr;
+
+static ThreadRing &thread_ring() {
+    if (!local_ring) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(std::make_unique<ThreadRing>());
+        local_ring = registry.back().get();
+        local_ring->tid = (uint32_t)registry.size();
+        local_ring->name = "thread " + std::to_string(local_ring->tid);
+    }
+    return *local_ring;
+}
+
+uint64_t CpuTrace::now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void CpuTrace::record(char const *name, uint64_t start_ns, uint64_t end_ns) {
+    auto &ring = thread_ring();
+    auto index = ring.written.load(std::memory_order_relaxed);
+    ring.events[index % RING_CAPACITY] = {name, start_ns, end_ns};
+    // publish the slot to a concurrent dump
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+void CpuTrace::set_thread_name(std::string name) {
+    auto &ring = thread_ring();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    ring.name = std::move(name);
+}
+
+void CpuTrace::write_chrome_trace(std::string const &path) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open cpu trace file! " + path);
+    }
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    uint64_t origin = std::numeric_limits<uint64_t>::max();
+    for (auto const &ring : registry) {
+        auto written = ring->written.load(std::memory_order_acquire);
+        auto first = written > RING_CAPACITY ? written - RING_CAPACITY : 0;
+        for (auto i = first; i < written; ++i) {
+            origin = std::min(origin, ring->events[i % RING_CAPACITY].start_ns);
+        }
+    }
+
+    // chrome://tracing and Perfetto want microseconds
+    file << "{\"traceEvents\":[\n";
+    bool first_event = true;
+    for (auto const &ring : registry) {
+        file << (first_event ? "" : ",\n")
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+             << ring->tid << ",\"args\":{\"name\":\"" << ring->name << "\"}}";
+        first_event = false;
+        auto written = ring->written.load(std::memory_order_acquire);
+        auto first = written > RING_CAPACITY ? written - RING_CAPACITY : 0;
+        for (auto i = first; i < written; ++i) {
+            auto const &event = ring->events[i % RING_CAPACITY];
+            file << ",\n{\"name\":\"" << event.name
+                 << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << ring->tid
+                 << ",\"ts\":" << (double)(event.start_ns - origin) * 1e-3
+                 << ",\"dur\":"
+                 << (double)(event.end_ns - event.start_ns) * 1e-3 << "}";
+        }
+    }
+    file << "\n]}\n";
+}
@@ -0,0 +1,66 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_CPU_TRACE_H
+#define VK_TUTORIAL_CPU_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+typedef struct TraceEvent {
+    char const *name;  // must outlive the trace, string literals only
+    uint64_t start_ns;
+    uint64_t end_ns;
+} TraceEvent;
+
+// Scoped CPU markers for the hot paths. Every thread appends to its own
+// fixed size ring (single writer, no locks, oldest events overwritten), so a
+// zone costs two clock reads and a store. Disabled zones cost one relaxed
+// load. write_chrome_trace() should run once the traced threads are idle.
+class CpuTrace {
+   public:
+    static const uint32_t RING_CAPACITY = 1 << 16;  // events per thread
+
+    static void enable(bool on) {
+        enabled.store(on, std::memory_order_relaxed);
+    }
+    static bool is_enabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    static uint64_t now_ns();
+    static void record(char const *name, uint64_t start_ns, uint64_t end_ns);
+    // label the calling thread in the trace viewer
+    static void set_thread_name(std::string name);
+    static void write_chrome_trace(std::string const &path);
+
+   private:
+    static std::atomic<bool> enabled;
+};
+
+class CpuZone {
+   public:
+    explicit CpuZone(char const *name)
+        : name(name),
+          start_ns(CpuTrace::is_enabled() ? CpuTrace::now_ns() : 0) {}
+    ~CpuZone() {
+        if (start_ns != 0) {
+            CpuTrace::record(name, start_ns, CpuTrace::now_ns());
+        }
+    }
+    CpuZone(CpuZone const &) = delete;
+    CpuZone &operator=(CpuZone const &) = delete;
+
+   private:
+    char const *name;
+    uint64_t start_ns;
+};
+
+#define CPU_ZONE_CONCAT_(a, b) a##b
+#define CPU_ZONE_CONCAT(a, b) CPU_ZONE_CONCAT_(a, b)
+// CPU_ZONE("name") traces the rest of the enclosing scope
+#define CPU_ZONE(name) CpuZone CPU_ZONE_CONCAT(cpu_zone_, __LINE__)(name)
+#define CPU_ZONE_FUNCTION() CPU_ZONE(__func__)
+
+#endif  // VK_TUTORIAL_CPU_TRACE_H
@@ -0,0 +1,47 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "deletion_queue.h"
+
+#include <algorithm>
+
+void DeletionQueue::push(uint64_t frame, VkDeviceSize bytes,
+                         std::function<void()> destroy) {
+    // a late push for an older frame must not be freed before its neighbours
+    if (!entries.empty()) {
+        frame = std::max(frame, entries.back().frame);
+    }
+    entries.push_back({frame, bytes, std::move(destroy)});
+    counters.depth = entries.size();
+    counters.bytes_pending += bytes;
+    counters.peak_depth = std::max(counters.peak_depth, counters.depth);
+    counters.peak_bytes = std::max(counters.peak_bytes, counters.bytes_pending);
+}
+
+void DeletionQueue::pop_front() {
+    auto entry = std::move(entries.front());
+    entries.pop_front();
+    entry.destroy();
+    counters.depth = entries.size();
+    counters.bytes_pending -= entry.bytes;
+    ++counters.destroyed;
+}
+
+void DeletionQueue::collect(uint64_t completed_frame) {
+    while (!entries.empty() && entries.front().frame <= completed_frame) {
+        pop_front();
+    }
+}
+
+void DeletionQueue::flush() {
+    while (!entries.empty()) {
+        pop_front();
+    }
+}
+
+void DeletionQueue::print_stats(std::ostream &os) const {
+    os << "deletion queue: " << counters.destroyed << " destroyed, peak depth "
+       << counters.peak_depth << ", peak "
+       << counters.peak_bytes / (1024.0 * 1024.0) << " MiB pending, "
+       << counters.depth << " still queued\n";
+}
@@ -0,0 +1,53 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_DELETION_QUEUE_H
+#define VK_TUTORIAL_DELETION_QUEUE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <ostream>
+
+typedef struct DeletionQueueStats {
+    size_t depth{0};               // entries waiting for the GPU
+    VkDeviceSize bytes_pending{0};  // device memory held by those entries
+    size_t peak_depth{0};
+    VkDeviceSize peak_bytes{0};
+    uint64_t destroyed{0};  // entries released so far
+} DeletionQueueStats;
+
+// Defers destruction of GPU objects until the frame that last used them has
+// finished. Every entry is tagged with a frame number (the value the frame
+// fences are associated with), collect() runs everything the GPU has passed.
+// Entries are pushed with monotonically increasing frame numbers, so the
+// queue stays sorted and collect() only looks at the front.
+class DeletionQueue {
+   public:
+    void push(uint64_t frame, VkDeviceSize bytes,
+              std::function<void()> destroy);
+    // destroy everything tagged with a frame <= completed_frame
+    void collect(uint64_t completed_frame);
+    // destroy everything, the device must be idle
+    void flush();
+
+    DeletionQueueStats stats() const { return counters; }
+    void print_stats(std::ostream &os) const;
+
+   private:
+    typedef struct Entry {
+        uint64_t frame;
+        VkDeviceSize bytes;
+        std::function<void()> destroy;
+    } Entry;
+
+    std::deque<Entry> entries;
+    DeletionQueueStats counters;
+
+    void pop_front();
+};
+
+#endif  // VK_TUTORIAL_DELETION_QUEUE_H
@@ -7,6 +7,7 @@
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <array>
 
 namespace EigenHelper {
 
@@ -42,7 +43,7 @@ inline Mat4f perspective(float fovy, float aspect, float z_near, float z_far) {
   return result;
 }
 
-Eigen::Matrix4f ortho(float left, float right, float bottom, float top,
+inline Eigen::Matrix4f ortho(float left, float right, float bottom, float top,
                       float zNear, float zFar) {
   Eigen::Matrix4f result = Eigen::Matrix4f::Identity();
   result(0, 0) = 2 / (right - left);
@@ -79,5 +80,36 @@ inline Eigen::Matrix4f lookAt(Eigen::Vector3f const &eye,
   result(2, 3) = f.dot(eye);
   return result;
 }
+// planes of the clip volume of project * view (Gribb/Hartmann), as
+// (normal, d) with the normal pointing inside and normalized so that
+// normal.dot(p) + d is the signed distance of p. perspective() maps depth to
+// [-1, 1], so its near plane is conservative for a [0, 1] clip volume
+inline std::array<Vec4f, 6> frustum_planes(Mat4f const &project_view) {
+  auto const &m = project_view;
+  std::array<Vec4f, 6> planes = {
+      (m.row(3) + m.row(0)).transpose(),  // left
+      (m.row(3) - m.row(0)).transpose(),  // right
+      (m.row(3) + m.row(1)).transpose(),  // bottom
+      (m.row(3) - m.row(1)).transpose(),  // top
+      (m.row(3) + m.row(2)).transpose(),  // near
+      (m.row(3) - m.row(2)).transpose(),  // far
+  };
+  for (auto &plane : planes) {
+    plane /= plane.head<3>().norm();
+  }
+  return planes;
+}
+
+// false once the sphere is fully behind one plane, FrustumCuller's SIMD
+// kernels must give the same answer
+inline bool sphere_in_frustum(std::array<Vec4f, 6> const &planes,
+                              Vec3f const &center, float radius) {
+  for (auto const &plane : planes) {
+    if (plane.head<3>().dot(center) + plane.w() < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
 } // namespace EigenHelper
 #endif // VK_TUTORIAL_GEOMETRY_HELPER_HPP
@@ -0,0 +1,97 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+char const *FrameStats::phase_name(FramePhase phase) {
+    static char const *names[FRAME_PHASE_COUNT] = {
+        "wait", "acquire", "update", "record", "submit", "present", "total"};
+    return names[phase];
+}
+
+// nearest-rank percentile of an ascending sequence
+static double percentile(std::vector<double> const &sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    auto rank = (size_t)std::ceil(p / 100.0 * (double)sorted.size());
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+PhaseSummary FrameStats::summarize(FramePhase phase) const {
+    PhaseSummary summary;
+    if (frames.empty()) {
+        return summary;
+    }
+    std::vector<double> values;
+    values.reserve(frames.size());
+    double sum = 0.0;
+    for (auto const &frame : frames) {
+        values.push_back(frame[phase]);
+        sum += frame[phase];
+    }
+    std::sort(values.begin(), values.end());
+    summary.mean = sum / (double)values.size();
+    summary.p50 = percentile(values, 50.0);
+    summary.p95 = percentile(values, 95.0);
+    summary.p99 = percentile(values, 99.0);
+    summary.max = values.back();
+    return summary;
+}
+
+void FrameStats::print_summary(std::ostream &os) const {
+    os << "benchmark: " << frames.size() << " frames (ms)\n";
+    os << std::fixed << std::setprecision(3);
+    os << "  phase        mean      p50      p95      p99      max\n";
+    for (int i = 0; i < FRAME_PHASE_COUNT; ++i) {
+        auto s = summarize((FramePhase)i);
+        os << "  " << std::left << std::setw(8) << phase_name((FramePhase)i)
+           << std::right << std::setw(9) << s.mean << std::setw(9) << s.p50
+           << std::setw(9) << s.p95 << std::setw(9) << s.p99 << std::setw(9)
+           << s.max << '\n';
+    }
+    os << std::defaultfloat;
+}
+
+void FrameStats::write_report(
+    std::string const &path,
+    std::vector<std::pair<std::string, std::string>> const &config) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open benchmark report! " + path);
+    }
+    file << std::fixed << std::setprecision(4);
+
+    bool csv =
+        path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    if (csv) {
+        file << "phase,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+        for (int i = 0; i < FRAME_PHASE_COUNT; ++i) {
+            auto s = summarize((FramePhase)i);
+            file << phase_name((FramePhase)i) << ',' << s.mean << ',' << s.p50
+                 << ',' << s.p95 << ',' << s.p99 << ',' << s.max << '\n';
+        }
+        return;
+    }
+
+    file << "{\n  \"frames\": " << frames.size() << ",\n  \"config\": {";
+    for (size_t i = 0; i < config.size(); ++i) {
+        file << (i == 0 ? "\n" : ",\n") << "    \"" << config[i].first
+             << "\": \"" << config[i].second << '"';
+    }
+    file << "\n  },\n  \"phases_ms\": {";
+    for (int i = 0; i < FRAME_PHASE_COUNT; ++i) {
+        auto s = summarize((FramePhase)i);
+        file << (i == 0 ? "\n" : ",\n") << "    \""
+             << phase_name((FramePhase)i) << "\": {\"mean\": " << s.mean
+             << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95
+             << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << '}';
+    }
+    file << "\n  }\n}\n";
+}
@@ -0,0 +1,60 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_FRAME_STATS_H
+#define VK_TUTORIAL_FRAME_STATS_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// host side phases of draw_frame, in the order they run
+enum FramePhase {
+    FRAME_PHASE_WAIT = 0,  // blocked on the frame timeline
+    FRAME_PHASE_ACQUIRE,
+    FRAME_PHASE_UPDATE,
+    FRAME_PHASE_RECORD,
+    FRAME_PHASE_SUBMIT,
+    FRAME_PHASE_PRESENT,
+    FRAME_PHASE_TOTAL,
+    FRAME_PHASE_COUNT
+};
+
+typedef std::array<double, FRAME_PHASE_COUNT> FrameTimes;  // milliseconds
+
+typedef struct PhaseSummary {
+    double mean{0.0};
+    double p50{0.0};
+    double p95{0.0};
+    double p99{0.0};
+    double max{0.0};
+} PhaseSummary;
+
+// Collects per-frame phase timings of a benchmark run and reduces them to
+// percentiles. Reports are flat and stable in key order so two runs can be
+// diffed directly.
+class FrameStats {
+   public:
+    static char const *phase_name(FramePhase phase);
+
+    void reserve(uint32_t frame_count) { frames.reserve(frame_count); }
+    void add_frame(FrameTimes const &times) { frames.push_back(times); }
+    size_t frame_count() const { return frames.size(); }
+
+    PhaseSummary summarize(FramePhase phase) const;
+    void print_summary(std::ostream &os) const;
+    // `.csv` writes one row per phase, anything else JSON; `config` is
+    // copied into the report verbatim as string key/value pairs
+    void write_report(
+        std::string const &path,
+        std::vector<std::pair<std::string, std::string>> const &config) const;
+
+   private:
+    std::vector<FrameTimes> frames;
+};
+
+#endif  // VK_TUTORIAL_FRAME_STATS_H
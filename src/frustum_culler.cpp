@@ -0,0 +1,269 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "frustum_culler.h"
+
+#include <algorithm>
+
+#include "eigen_helper.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLER_SSE 1
+#include <immintrin.h>
+#endif
+
+// gcc and clang can compile the AVX2 kernel on its own and pick it at
+// runtime, msvc only gets it when the whole build targets AVX2
+#if defined(FRUSTUM_CULLER_SSE) && (defined(__GNUC__) || defined(__AVX2__))
+#define FRUSTUM_CULLER_AVX2 1
+#if defined(__GNUC__) && !defined(__AVX2__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+typedef std::array<Eigen::Vector4f, 6> Planes;
+
+// the spheres a kernel works on, [begin, end) with begin a multiple of BATCH
+typedef struct SphereRange {
+    float const *x;
+    float const *y;
+    float const *z;
+    float const *r;
+    uint32_t begin;
+    uint32_t end;
+} SphereRange;
+
+static uint32_t lowest_bit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+// append base + i for every set bit i of mask, returns the new count
+static uint32_t emit_visible(uint32_t mask, uint32_t base, uint32_t *out,
+                             uint32_t n) {
+    while (mask) {
+        out[n++] = base + lowest_bit(mask);
+        mask &= mask - 1;
+    }
+    return n;
+}
+
+// tail of the last batch, bit i set if begin + i < end
+static uint32_t tail_mask(uint32_t begin, uint32_t end) {
+    auto left = end - begin;
+    return left >= 32 ? UINT32_MAX : (1u << left) - 1;
+}
+
+// the reference path, tools/cull_bench checks the SIMD kernels against it
+static uint32_t cull_scalar(Planes const &planes, SphereRange const &s,
+                            uint32_t *out) {
+    uint32_t n = 0;
+    for (uint32_t i = s.begin; i < s.end; ++i) {
+        Eigen::Vector3f center(s.x[i], s.y[i], s.z[i]);
+        if (EigenHelper::sphere_in_frustum(planes, center, s.r[i])) {
+            out[n++] = i;
+        }
+    }
+    return n;
+}
+
+#if defined(FRUSTUM_CULLER_SSE)
+// 4 spheres against all planes, returns the 4 bit outside mask; the sums
+// run in sphere_in_frustum's order so every path agrees on spheres that
+// just touch a plane
+static inline int outside_sse(__m128 const (&plane)[6][4], SphereRange const &s,
+                              uint32_t i) {
+    auto x = _mm_loadu_ps(s.x + i);
+    auto y = _mm_loadu_ps(s.y + i);
+    auto z = _mm_loadu_ps(s.z + i);
+    auto neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(s.r + i));
+    auto outside = _mm_setzero_ps();
+    for (auto const &p : plane) {
+        auto d = _mm_add_ps(_mm_mul_ps(p[0], x), _mm_mul_ps(p[1], y));
+        d = _mm_add_ps(_mm_add_ps(d, _mm_mul_ps(p[2], z)), p[3]);
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(d, neg_r));
+    }
+    return _mm_movemask_ps(outside);
+}
+
+static uint32_t cull_sse(Planes const &planes, SphereRange const &s,
+                         uint32_t *out) {
+    __m128 plane[6][4];
+    for (int k = 0; k < 6; ++k) {
+        for (int c = 0; c < 4; ++c) {
+            plane[k][c] = _mm_set1_ps(planes[k][c]);
+        }
+    }
+    uint32_t n = 0;
+    for (uint32_t i = s.begin; i < s.end; i += 8) {
+        // two registers per iteration so the plane chains overlap
+        uint32_t outside = outside_sse(plane, s, i) |
+                           (outside_sse(plane, s, i + 4) << 4);
+        auto mask = ~outside & 0xffu & tail_mask(i, s.end);
+        n = emit_visible(mask, i, out, n);
+    }
+    return n;
+}
+#endif
+
+#if defined(FRUSTUM_CULLER_AVX2)
+AVX2_TARGET static inline int outside_avx2(__m256 const (&plane)[6][4],
+                                           SphereRange const &s, uint32_t i) {
+    auto x = _mm256_loadu_ps(s.x + i);
+    auto y = _mm256_loadu_ps(s.y + i);
+    auto z = _mm256_loadu_ps(s.z + i);
+    auto neg_r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(s.r + i));
+    auto outside = _mm256_setzero_ps();
+    for (auto const &p : plane) {
+        auto d = _mm256_add_ps(_mm256_mul_ps(p[0], x), _mm256_mul_ps(p[1], y));
+        d = _mm256_add_ps(_mm256_add_ps(d, _mm256_mul_ps(p[2], z)), p[3]);
+        outside =
+            _mm256_or_ps(outside, _mm256_cmp_ps(d, neg_r, _CMP_LT_OQ));
+    }
+    return _mm256_movemask_ps(outside);
+}
+
+AVX2_TARGET static uint32_t cull_avx2(Planes const &planes,
+                                      SphereRange const &s, uint32_t *out) {
+    __m256 plane[6][4];
+    for (int k = 0; k < 6; ++k) {
+        for (int c = 0; c < 4; ++c) {
+            plane[k][c] = _mm256_set1_ps(planes[k][c]);
+        }
+    }
+    uint32_t n = 0;
+    for (uint32_t i = s.begin; i < s.end; i += 16) {
+        uint32_t outside = outside_avx2(plane, s, i) |
+                           (outside_avx2(plane, s, i + 8) << 8);
+        auto mask = ~outside & 0xffffu & tail_mask(i, s.end);
+        n = emit_visible(mask, i, out, n);
+    }
+    return n;
+}
+#endif
+
+bool FrustumCuller::is_supported(CullPath path) {
+    switch (path) {
+        case CULL_PATH_SCALAR:
+            return true;
+#if defined(FRUSTUM_CULLER_SSE)
+        case CULL_PATH_SSE:
+            return true;
+#endif
+#if defined(FRUSTUM_CULLER_AVX2)
+        case CULL_PATH_AVX2:
+#if defined(__AVX2__)
+            return true;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+#endif
+        default:
+            return false;
+    }
+}
+
+CullPath FrustumCuller::best_path() {
+    if (is_supported(CULL_PATH_AVX2)) {
+        return CULL_PATH_AVX2;
+    }
+    if (is_supported(CULL_PATH_SSE)) {
+        return CULL_PATH_SSE;
+    }
+    return CULL_PATH_SCALAR;
+}
+
+char const *FrustumCuller::path_name(CullPath path) {
+    switch (path) {
+        case CULL_PATH_SSE:
+            return "sse";
+        case CULL_PATH_AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+void FrustumCuller::resize(uint32_t count) {
+    this->count = count;
+    auto padded = (count + BATCH - 1) / BATCH * BATCH;
+    // padding spheres sit at the origin with radius 0 and get masked anyway
+    center_x.assign(padded, 0.0f);
+    center_y.assign(padded, 0.0f);
+    center_z.assign(padded, 0.0f);
+    radius.assign(padded, 0.0f);
+}
+
+void FrustumCuller::set_sphere(uint32_t index, Eigen::Vector3f const &center,
+                               float radius) {
+    center_x[index] = center.x();
+    center_y[index] = center.y();
+    center_z[index] = center.z();
+    this->radius[index] = radius;
+}
+
+void FrustumCuller::cull(Planes const &planes, std::vector<uint32_t> &visible,
+                         ThreadPool *pool) {
+    if (!is_supported(path)) {
+        path = best_path();
+    }
+    auto kernel = cull_scalar;
+#if defined(FRUSTUM_CULLER_SSE)
+    if (path == CULL_PATH_SSE) {
+        kernel = cull_sse;
+    }
+#endif
+#if defined(FRUSTUM_CULLER_AVX2)
+    if (path == CULL_PATH_AVX2) {
+        kernel = cull_avx2;
+    }
+#endif
+
+    uint32_t job_count = 1;
+    if (pool && pool->size() > 0) {
+        job_count = std::clamp(count / MIN_JOB_SPHERES, 1u, pool->size());
+    }
+    // jobs split on whole batches, only the last one has a masked tail
+    auto batches = (count + BATCH - 1) / BATCH;
+    auto batches_per_job = (batches + job_count - 1) / job_count;
+    if (batches_per_job > 0) {
+        job_count = (batches + batches_per_job - 1) / batches_per_job;
+    }
+
+    visible.resize(count);
+    if (job_count <= 1) {
+        SphereRange range{center_x.data(), center_y.data(), center_z.data(),
+                          radius.data(),   0,               count};
+        visible.resize(kernel(planes, range, visible.data()));
+        return;
+    }
+
+    // each job writes its own slice of visible, compacted afterwards
+    std::vector<uint32_t> job_found(job_count);
+    pool->parallel_for(job_count, [&](uint32_t job, uint32_t) {
+        auto begin = job * batches_per_job * BATCH;
+        auto end = std::min(begin + batches_per_job * BATCH, count);
+        SphereRange range{center_x.data(), center_y.data(), center_z.data(),
+                          radius.data(),   begin,           end};
+        job_found[job] = kernel(planes, range, visible.data() + begin);
+    });
+    uint32_t n = job_found[0];
+    for (uint32_t job = 1; job < job_count; ++job) {
+        auto begin = visible.begin() + job * batches_per_job * BATCH;
+        n = std::copy(begin, begin + job_found[job], visible.begin() + n) -
+            visible.begin();
+    }
+    visible.resize(n);
+}
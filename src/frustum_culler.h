@@ -0,0 +1,57 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_FRUSTUM_CULLER_H
+#define VK_TUTORIAL_FRUSTUM_CULLER_H
+
+#include <Eigen/Core>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "thread_pool.h"
+
+typedef enum CullPath {
+    CULL_PATH_SCALAR,
+    CULL_PATH_SSE,   // 8 spheres per iteration, two 4 wide registers
+    CULL_PATH_AVX2,  // 16 spheres per iteration, two 8 wide registers
+} CullPath;
+
+// CPU frustum culling for when there is no GPU culling pass. Bounding
+// spheres are kept as structure of arrays (x, y, z, radius streams) so one
+// plane test covers a whole register of spheres. The arrays are padded to
+// BATCH spheres, the tail of the last batch is masked out. The AVX2 path is
+// chosen at runtime where the CPU has it, the scalar one is always there.
+class FrustumCuller {
+   public:
+    static const uint32_t BATCH = 16;  // spheres per iteration, widest path
+    // below this many spheres per job the pool is not worth waking up
+    static const uint32_t MIN_JOB_SPHERES = 4096;
+
+    static bool is_supported(CullPath path);
+    static CullPath best_path();
+    static char const *path_name(CullPath path);
+
+    void resize(uint32_t count);
+    uint32_t size() const { return count; }
+    void set_sphere(uint32_t index, Eigen::Vector3f const &center,
+                    float radius);
+    void set_path(CullPath path) { this->path = path; }
+    CullPath current_path() const { return path; }
+
+    // replaces visible with the indices of every sphere touching the
+    // frustum, ascending; planes as from EigenHelper::frustum_planes
+    void cull(std::array<Eigen::Vector4f, 6> const &planes,
+              std::vector<uint32_t> &visible, ThreadPool *pool = nullptr);
+
+   private:
+    std::vector<float> center_x;
+    std::vector<float> center_y;
+    std::vector<float> center_z;
+    std::vector<float> radius;
+    uint32_t count{0};
+    CullPath path{best_path()};
+};
+
+#endif  // VK_TUTORIAL_FRUSTUM_CULLER_H
@@ -0,0 +1,185 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+void GpuProfiler::init(VkPhysicalDevice physical_device, VkDevice device,
+                       uint32_t queue_family, uint32_t slot_count,
+                       bool host_query_reset, std::string track_name) {
+    this->device = device;
+    this->track_name = std::move(track_name);
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count,
+                                             nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count,
+                                             families.data());
+    auto valid_bits = families[queue_family].timestampValidBits;
+    if (!host_query_reset || valid_bits == 0 ||
+        properties.limits.timestampPeriod == 0.0f) {
+        enabled = false;
+        return;
+    }
+    timestamp_period = properties.limits.timestampPeriod;
+    timestamp_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+    slots.resize(slot_count);
+    for (auto &slot : slots) {
+        VkQueryPoolCreateInfo pool_info{
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = MAX_ZONES * 2};
+        if (vkCreateQueryPool(device, &pool_info, nullptr, &slot.pool) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+        vkResetQueryPool(device, slot.pool, 0, MAX_ZONES * 2);
+    }
+    enabled = true;
+}
+
+void GpuProfiler::destroy() {
+    for (auto &slot : slots) {
+        vkDestroyQueryPool(device, slot.pool, nullptr);
+    }
+    slots.clear();
+    enabled = false;
+}
+
+void GpuProfiler::begin_frame(uint32_t slot, uint64_t frame) {
+    if (!enabled) {
+        return;
+    }
+    current = slot;
+    auto &entry = slots[slot];
+    resolve(entry);
+    entry.frame = frame;
+    vkResetQueryPool(device, entry.pool, 0, MAX_ZONES * 2);
+}
+
+uint32_t GpuProfiler::begin_zone(VkCommandBuffer command_buffer,
+                                 char const *name,
+                                 VkPipelineStageFlagBits stage) {
+    if (!enabled || slots[current].names.size() >= MAX_ZONES) {
+        return UINT32_MAX;
+    }
+    auto &slot = slots[current];
+    auto zone = (uint32_t)slot.names.size();
+    slot.names.emplace_back(name);
+    vkCmdWriteTimestamp(command_buffer, stage, slot.pool, zone * 2);
+    return zone;
+}
+
+void GpuProfiler::end_zone(VkCommandBuffer command_buffer, uint32_t zone,
+                           VkPipelineStageFlagBits stage) {
+    if (!enabled || zone == UINT32_MAX) {
+        return;
+    }
+    vkCmdWriteTimestamp(command_buffer, stage, slots[current].pool,
+                        zone * 2 + 1);
+}
+
+void GpuProfiler::resolve(Slot &slot) {
+    if (slot.names.empty()) {
+        return;
+    }
+    auto query_count = (uint32_t)slot.names.size() * 2;
+    std::vector<uint64_t> ticks(query_count);
+    auto result = vkGetQueryPoolResults(
+        device, slot.pool, 0, query_count, ticks.size() * sizeof(uint64_t),
+        ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    auto names = std::move(slot.names);
+    slot.names.clear();
+    if (result != VK_SUCCESS) {
+        return;  // recorded but never submitted (record benchmark)
+    }
+
+    last.clear();
+    for (size_t i = 0; i < names.size(); ++i) {
+        auto begin = ticks[i * 2] & timestamp_mask;
+        auto end = ticks[i * 2 + 1] & timestamp_mask;
+        auto duration_ms =
+            end >= begin ? (double)(end - begin) * timestamp_period * 1e-6 : 0;
+        GpuZoneResult zone{.name = names[i],
+                           .frame = slot.frame,
+                           .start_ns = (double)begin * timestamp_period,
+                           .duration_ms = duration_ms};
+        auto &total = totals[zone.name];
+        total.total_ms += duration_ms;
+        total.max_ms = std::max(total.max_ms, duration_ms);
+        ++total.count;
+        if (trace.size() < MAX_TRACE_EVENTS) {
+            trace.push_back(zone);
+        }
+        last.push_back(std::move(zone));
+    }
+}
+
+void GpuProfiler::resolve_all() {
+    for (auto &slot : slots) {
+        resolve(slot);
+    }
+}
+
+double GpuProfiler::average_ms(std::string const &name) const {
+    auto it = totals.find(name);
+    if (it == totals.end() || it->second.count == 0) {
+        return 0.0;
+    }
+    return it->second.total_ms / (double)it->second.count;
+}
+
+void GpuProfiler::print_summary(std::ostream &os) const {
+    if (!enabled) {
+        os << "gpu " << track_name << ": no timestamp support\n";
+        return;
+    }
+    for (auto const &[name, total] : totals) {
+        os << "gpu " << track_name << " " << name << ": avg "
+           << total.total_ms / (double)total.count << " ms, max "
+           << total.max_ms << " ms over " << total.count << " samples\n";
+    }
+}
+
+void GpuProfiler::write_chrome_trace(
+    std::string const &path,
+    std::vector<GpuProfiler const *> const &profilers) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open gpu trace file! " + path);
+    }
+    // chrome://tracing and Perfetto want microseconds, start at zero
+    double origin = std::numeric_limits<double>::max();
+    for (auto profiler : profilers) {
+        for (auto const &zone : profiler->trace) {
+            origin = std::min(origin, zone.start_ns);
+        }
+    }
+
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (size_t tid = 0; tid < profilers.size(); ++tid) {
+        auto profiler = profilers[tid];
+        file << (first ? "" : ",\n")
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+             << tid << ",\"args\":{\"name\":\"gpu " << profiler->track_name
+             << "\"}}";
+        first = false;
+        for (auto const &zone : profiler->trace) {
+            file << ",\n{\"name\":\"" << zone.name
+                 << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                 << ",\"ts\":" << (zone.start_ns - origin) * 1e-3
+                 << ",\"dur\":" << zone.duration_ms * 1e3
+                 << ",\"args\":{\"frame\":" << zone.frame << "}}";
+        }
+    }
+    file << "\n]}\n";
+}
@@ -0,0 +1,88 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_GPU_PROFILER_H
+#define VK_TUTORIAL_GPU_PROFILER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+typedef struct GpuZoneResult {
+    std::string name;
+    uint64_t frame;
+    double start_ns;  // device timestamp converted with timestampPeriod
+    double duration_ms;
+} GpuZoneResult;
+
+// Timestamp query zones for one queue. Every slot (frame in flight, upload
+// batch, ...) owns a query pool; begin_frame() reads back what the slot
+// recorded the previous time it was used, which the caller guarantees has
+// finished, so results arrive one round later without ever stalling.
+// Pools are reset from the host (hostQueryReset) since transfer queues can
+// not record vkCmdResetQueryPool. Disabled silently when the queue family
+// has no timestamp support or the device lacks host query reset.
+class GpuProfiler {
+   public:
+    static const uint32_t MAX_ZONES = 32;  // per slot
+    static const size_t MAX_TRACE_EVENTS = 1 << 18;
+
+    void init(VkPhysicalDevice physical_device, VkDevice device,
+              uint32_t queue_family, uint32_t slot_count,
+              bool host_query_reset, std::string track_name);
+    void destroy();
+    bool is_enabled() const { return enabled; }
+
+    // resolve what the slot recorded last time, then reset its queries
+    void begin_frame(uint32_t slot, uint64_t frame);
+    uint32_t begin_zone(
+        VkCommandBuffer command_buffer, char const *name,
+        VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+    void end_zone(
+        VkCommandBuffer command_buffer, uint32_t zone,
+        VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    // read back every slot, only valid once the device is idle
+    void resolve_all();
+
+    std::vector<GpuZoneResult> const &last_results() const { return last; }
+    // mean over every resolved sample of the zone, 0 when never seen
+    double average_ms(std::string const &name) const;
+    void print_summary(std::ostream &os) const;
+    static void write_chrome_trace(
+        std::string const &path,
+        std::vector<GpuProfiler const *> const &profilers);
+
+   private:
+    typedef struct Slot {
+        VkQueryPool pool{VK_NULL_HANDLE};
+        std::vector<std::string> names;  // zone i uses queries 2i, 2i+1
+        uint64_t frame{0};
+    } Slot;
+
+    typedef struct ZoneTotal {
+        double total_ms{0.0};
+        double max_ms{0.0};
+        uint64_t count{0};
+    } ZoneTotal;
+
+    VkDevice device{VK_NULL_HANDLE};
+    bool enabled{false};
+    double timestamp_period{1.0};  // nanoseconds per tick
+    uint64_t timestamp_mask{~0ull};
+    std::string track_name;
+    std::vector<Slot> slots;
+    uint32_t current{0};
+
+    std::vector<GpuZoneResult> last;
+    std::vector<GpuZoneResult> trace;
+    std::map<std::string, ZoneTotal> totals;
+
+    void resolve(Slot &slot);
+};
+
+#endif  // VK_TUTORIAL_GPU_PROFILER_H
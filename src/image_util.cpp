@@ -0,0 +1,180 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "image_util.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+uint32_t mip_level_count(uint32_t width, uint32_t height) {
+    uint32_t levels = 1;
+    for (auto size = std::max(width, height); size > 1; size >>= 1) {
+        ++levels;
+    }
+    return levels;
+}
+
+bool supports_linear_blit(VkPhysicalDevice physical_device, VkFormat format) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(physical_device, format, &properties);
+    VkFormatFeatureFlags required =
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (properties.optimalTilingFeatures & required) == required;
+}
+
+bool supports_sampled_format(VkPhysicalDevice physical_device,
+                             VkFormat format) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(physical_device, format, &properties);
+    return properties.optimalTilingFeatures &
+           VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+}
+
+void record_mip_blits(VkCommandBuffer command_buffer, VkImage image,
+                      uint32_t width, uint32_t height, uint32_t mip_levels) {
+    VkImageMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                          .levelCount = 1,
+                          .baseArrayLayer = 0,
+                          .layerCount = 1}};
+
+    auto mip_width = (int32_t)width;
+    auto mip_height = (int32_t)height;
+    for (uint32_t level = 1; level < mip_levels; ++level) {
+        // the previous level was just written, read it as the blit source
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                             nullptr, 1, &barrier);
+
+        auto next_width = std::max(mip_width / 2, 1);
+        auto next_height = std::max(mip_height / 2, 1);
+        VkImageBlit blit{
+            .srcSubresource{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .mipLevel = level - 1,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1},
+            .srcOffsets{{0, 0, 0}, {mip_width, mip_height, 1}},
+            .dstSubresource{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .mipLevel = level,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1},
+            .dstOffsets{{0, 0, 0}, {next_width, next_height, 1}}};
+        vkCmdBlitImage(command_buffer, image,
+                       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                       VK_FILTER_LINEAR);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+                             nullptr, 0, nullptr, 1, &barrier);
+        mip_width = next_width;
+        mip_height = next_height;
+    }
+
+    // the last level is only ever written
+    barrier.subresourceRange.baseMipLevel = mip_levels - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+}
+
+static std::array<float, 256> const &srgb_to_linear_table() {
+    static auto const table = []() {
+        std::array<float, 256> result{};
+        for (int i = 0; i < 256; ++i) {
+            float c = (float)i / 255.0f;
+            result[i] = c <= 0.04045f ? c / 12.92f
+                                      : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return result;
+    }();
+    return table;
+}
+
+static unsigned char linear_to_srgb(float c) {
+    c = std::clamp(c, 0.0f, 1.0f);
+    c = c <= 0.0031308f ? c * 12.92f
+                        : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    return (unsigned char)std::lround(c * 255.0f);
+}
+
+std::vector<unsigned char> build_mip_chain_rgba8(unsigned char const *pixels,
+                                                 uint32_t width,
+                                                 uint32_t height,
+                                                 uint32_t mip_levels,
+                                                 bool srgb) {
+    size_t total = 0;
+    for (uint32_t level = 0; level < mip_levels; ++level) {
+        total += (size_t)std::max(width >> level, 1u) *
+                 std::max(height >> level, 1u) * 4;
+    }
+    std::vector<unsigned char> chain(total);
+    memcpy(chain.data(), pixels, (size_t)width * height * 4);
+
+    auto const &to_linear = srgb_to_linear_table();
+    size_t src_offset = 0;
+    size_t dst_offset = (size_t)width * height * 4;
+    uint32_t src_width = width, src_height = height;
+    for (uint32_t level = 1; level < mip_levels; ++level) {
+        auto dst_width = std::max(src_width / 2, 1u);
+        auto dst_height = std::max(src_height / 2, 1u);
+        auto const *src = chain.data() + src_offset;
+        auto *dst = chain.data() + dst_offset;
+        for (uint32_t y = 0; y < dst_height; ++y) {
+            for (uint32_t x = 0; x < dst_width; ++x) {
+                // odd sizes clamp the second tap to the edge
+                uint32_t x0 = std::min(x * 2, src_width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, src_width - 1);
+                uint32_t y0 = std::min(y * 2, src_height - 1);
+                uint32_t y1 = std::min(y * 2 + 1, src_height - 1);
+                unsigned char const *taps[4] = {
+                    src + (y0 * src_width + x0) * 4,
+                    src + (y0 * src_width + x1) * 4,
+                    src + (y1 * src_width + x0) * 4,
+                    src + (y1 * src_width + x1) * 4};
+                auto *out = dst + (y * dst_width + x) * 4;
+                for (int c = 0; c < 4; ++c) {
+                    // alpha is always linear
+                    if (srgb && c < 3) {
+                        float sum = 0.0f;
+                        for (auto tap : taps) {
+                            sum += to_linear[tap[c]];
+                        }
+                        out[c] = linear_to_srgb(sum * 0.25f);
+                    } else {
+                        uint32_t sum = 0;
+                        for (auto tap : taps) {
+                            sum += tap[c];
+                        }
+                        out[c] = (unsigned char)((sum + 2) / 4);
+                    }
+                }
+            }
+        }
+        src_offset = dst_offset;
+        dst_offset += (size_t)dst_width * dst_height * 4;
+        src_width = dst_width;
+        src_height = dst_height;
+    }
+    return chain;
+}
@@ -0,0 +1,42 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_IMAGE_UTIL_H
+#define VK_TUTORIAL_IMAGE_UTIL_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+typedef enum MipGeneration {
+    MIP_GENERATION_NONE,  // single level
+    MIP_GENERATION_BLIT,  // vkCmdBlitImage on the graphics queue
+    MIP_GENERATION_CPU,   // box filtered on the decode thread
+} MipGeneration;
+
+// floor(log2(max(width, height))) + 1
+uint32_t mip_level_count(uint32_t width, uint32_t height);
+// blit based generation needs linear filtering on optimal tiled images
+bool supports_linear_blit(VkPhysicalDevice physical_device, VkFormat format);
+// optimal tiled images of this format can be sampled (BCn / ASTC support
+// varies between desktop and mobile GPUs)
+bool supports_sampled_format(VkPhysicalDevice physical_device,
+                             VkFormat format);
+
+// Expects every level in TRANSFER_DST_OPTIMAL with level 0 filled, blits
+// each level from the previous one and leaves the whole chain in
+// SHADER_READ_ONLY_OPTIMAL. Must be recorded on a graphics queue.
+void record_mip_blits(VkCommandBuffer command_buffer, VkImage image,
+                      uint32_t width, uint32_t height, uint32_t mip_levels);
+
+// CPU fallback: 2x2 box filter (done in linear space when srgb), returns all
+// levels tightly packed, largest first, level 0 included
+std::vector<unsigned char> build_mip_chain_rgba8(unsigned char const *pixels,
+                                                 uint32_t width,
+                                                 uint32_t height,
+                                                 uint32_t mip_levels,
+                                                 bool srgb);
+
+#endif  // VK_TUTORIAL_IMAGE_UTIL_H
@@ -0,0 +1,280 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "ktx2.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static const unsigned char KTX2_IDENTIFIER[12] = {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+typedef struct Ktx2Header {
+    unsigned char identifier[12];
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+    uint64_t sgd_byte_offset;
+    uint64_t sgd_byte_length;
+} Ktx2Header;
+static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must be packed");
+
+typedef struct Ktx2Level {
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    uint64_t uncompressed_byte_length;
+} Ktx2Level;
+
+bool is_ktx2_path(std::string const &path) {
+    return path.size() > 5 && path.compare(path.size() - 5, 5, ".ktx2") == 0;
+}
+
+bool ktx2_block_info(VkFormat format, uint32_t &block_extent,
+                     uint32_t &block_bytes) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            block_extent = 1;
+            block_bytes = 4;
+            return true;
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            block_extent = 4;
+            block_bytes = 8;
+            return true;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+            block_extent = 4;
+            block_bytes = 16;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static uint64_t level_size(Ktx2Image const &image, uint32_t level) {
+    auto blocks = [&](uint32_t extent) {
+        extent = std::max(extent >> level, 1u);
+        return (uint64_t)(extent + image.block_extent - 1) /
+               image.block_extent;
+    };
+    return blocks(image.width) * blocks(image.height) * image.block_bytes;
+}
+
+static Ktx2Header read_header(std::ifstream &file, std::string const &path) {
+    Ktx2Header header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) !=
+            0) {
+        throw std::runtime_error("failed to read KTX2 header! " + path);
+    }
+    return header;
+}
+
+VkFormat peek_ktx2_format(std::string const &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open file! " + path);
+    }
+    return (VkFormat)read_header(file, path).vk_format;
+}
+
+Ktx2Image load_ktx2(std::string const &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open file! " + path);
+    }
+    auto header = read_header(file, path);
+    if (header.supercompression_scheme != 0 || header.pixel_depth > 1 ||
+        header.layer_count > 1 || header.face_count != 1) {
+        throw std::runtime_error("unsupported KTX2 layout! " + path);
+    }
+
+    Ktx2Image image{.format = (VkFormat)header.vk_format,
+                    .width = header.pixel_width,
+                    .height = std::max(header.pixel_height, 1u),
+                    .mip_levels = std::max(header.level_count, 1u)};
+    if (!ktx2_block_info(image.format, image.block_extent,
+                         image.block_bytes)) {
+        throw std::runtime_error("unsupported KTX2 format! " + path);
+    }
+
+    std::vector<Ktx2Level> levels(image.mip_levels);
+    file.read(reinterpret_cast<char *>(levels.data()),
+              levels.size() * sizeof(Ktx2Level));
+
+    // the file keeps the smallest level first, the uploader wants level 0
+    // first
+    uint64_t total = 0;
+    for (uint32_t level = 0; level < image.mip_levels; ++level) {
+        if (levels[level].byte_length != level_size(image, level)) {
+            throw std::runtime_error("corrupt KTX2 level index! " + path);
+        }
+        total += levels[level].byte_length;
+    }
+    image.data.resize(total);
+    uint64_t offset = 0;
+    for (uint32_t level = 0; level < image.mip_levels; ++level) {
+        file.seekg((std::streamoff)levels[level].byte_offset);
+        if (!file.read(reinterpret_cast<char *>(image.data.data() + offset),
+                       (std::streamsize)levels[level].byte_length)) {
+            throw std::runtime_error("failed to read KTX2 level! " + path);
+        }
+        offset += levels[level].byte_length;
+    }
+    return image;
+}
+
+static bool is_srgb(VkFormat format) {
+    return format == VK_FORMAT_R8G8B8A8_SRGB ||
+           format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK ||
+           format == VK_FORMAT_BC3_SRGB_BLOCK ||
+           format == VK_FORMAT_BC7_SRGB_BLOCK ||
+           format == VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
+}
+
+// Khronos basic data format descriptor, just enough for other tools to
+// identify the texel layout
+static std::vector<uint32_t> basic_dfd(Ktx2Image const &image) {
+    const uint32_t KHR_DF_MODEL_RGBSDA = 1;
+    const uint32_t KHR_DF_MODEL_BC1A = 128;
+    const uint32_t KHR_DF_MODEL_BC3 = 130;
+    const uint32_t KHR_DF_MODEL_BC7 = 134;
+    const uint32_t KHR_DF_MODEL_ASTC = 162;
+
+    typedef struct Sample {
+        uint32_t bit_offset, bit_length, channel, upper;
+    } Sample;
+    uint32_t model;
+    std::vector<Sample> samples;
+    switch (image.format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            model = KHR_DF_MODEL_RGBSDA;
+            // alpha is channel 15 and never sRGB encoded, so it carries
+            // the linear qualifier (KHR_DF_SAMPLE_DATATYPE_LINEAR, 0x10)
+            samples = {{0, 8, 0, 255},
+                       {8, 8, 1, 255},
+                       {16, 8, 2, 255},
+                       {24, 8, 15u | (is_srgb(image.format) ? 0x10u : 0u),
+                        255}};
+            break;
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            model = KHR_DF_MODEL_BC1A;
+            samples = {{0, 64, 1, UINT32_MAX}};
+            break;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+            model = KHR_DF_MODEL_BC3;
+            samples = {{0, 64, 15, UINT32_MAX}, {64, 64, 0, UINT32_MAX}};
+            break;
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            model = KHR_DF_MODEL_BC7;
+            samples = {{0, 128, 0, UINT32_MAX}};
+            break;
+        default:
+            model = KHR_DF_MODEL_ASTC;
+            samples = {{0, 128, 0, UINT32_MAX}};
+            break;
+    }
+
+    uint32_t block_size = 24 + 16 * (uint32_t)samples.size();
+    uint32_t extent = image.block_extent - 1;
+    std::vector<uint32_t> words = {
+        4 + block_size,  // dfdTotalSize
+        0,               // vendor khronos, descriptor type basic
+        2u | (block_size << 16),  // version 1.3
+        // model, primaries BT709, transfer sRGB(2)/linear(1), flags
+        model | (1u << 8) | ((is_srgb(image.format) ? 2u : 1u) << 16),
+        extent | (extent << 8),
+        image.block_bytes,  // bytesPlane0
+        0};
+    for (auto const &sample : samples) {
+        words.push_back(sample.bit_offset | ((sample.bit_length - 1) << 16) |
+                        (sample.channel << 24));
+        words.push_back(0);  // sample position
+        words.push_back(0);  // lower
+        words.push_back(sample.upper);
+    }
+    return words;
+}
+
+void write_ktx2(std::string const &path, Ktx2Image const &image) {
+    auto dfd = basic_dfd(image);
+    auto align = [](uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    };
+
+    Ktx2Header header{};
+    memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+    header.vk_format = image.format;
+    header.type_size = 1;
+    header.pixel_width = image.width;
+    header.pixel_height = image.height;
+    header.face_count = 1;
+    header.level_count = image.mip_levels;
+    header.dfd_byte_offset =
+        sizeof(Ktx2Header) + image.mip_levels * sizeof(Ktx2Level);
+    header.dfd_byte_length = (uint32_t)(dfd.size() * sizeof(uint32_t));
+
+    // level data must be aligned to lcm(texel block size, 4)
+    uint64_t alignment = image.block_bytes % 4 == 0 ? image.block_bytes
+                                                    : image.block_bytes * 4;
+    std::vector<Ktx2Level> levels(image.mip_levels);
+    std::vector<uint64_t> source_offsets(image.mip_levels);
+    uint64_t source = 0;
+    for (uint32_t level = 0; level < image.mip_levels; ++level) {
+        source_offsets[level] = source;
+        levels[level].byte_length = level_size(image, level);
+        levels[level].uncompressed_byte_length = levels[level].byte_length;
+        source += levels[level].byte_length;
+    }
+    if (source != image.data.size()) {
+        throw std::runtime_error("KTX2 image data does not match its size!");
+    }
+    uint64_t offset = header.dfd_byte_offset + header.dfd_byte_length;
+    for (auto level = image.mip_levels; level-- > 0;) {
+        offset = align(offset, alignment);
+        levels[level].byte_offset = offset;
+        offset += levels[level].byte_length;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open KTX2 output! " + path);
+    }
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    file.write(reinterpret_cast<char const *>(levels.data()),
+               levels.size() * sizeof(Ktx2Level));
+    file.write(reinterpret_cast<char const *>(dfd.data()),
+               dfd.size() * sizeof(uint32_t));
+    for (auto level = image.mip_levels; level-- > 0;) {
+        while ((uint64_t)file.tellp() < levels[level].byte_offset) {
+            file.put(0);
+        }
+        file.write(reinterpret_cast<char const *>(image.data.data() +
+                                                  source_offsets[level]),
+                   (std::streamsize)levels[level].byte_length);
+    }
+    if (!file) {
+        throw std::runtime_error("failed to write KTX2 file! " + path);
+    }
+}
@@ -0,0 +1,36 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_KTX2_H
+#define VK_TUTORIAL_KTX2_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A KTX2 texture (2D, one layer/face, no supercompression) whose levels are
+// kept in the container's GPU format, so uploading is a straight copy.
+typedef struct Ktx2Image {
+    VkFormat format{VK_FORMAT_UNDEFINED};
+    uint32_t width{0};
+    uint32_t height{0};
+    uint32_t mip_levels{1};
+    uint32_t block_extent{1};  // 4 for BCn / ASTC 4x4
+    uint32_t block_bytes{4};   // bytes per texel block
+    std::vector<unsigned char> data;  // levels packed largest first
+} Ktx2Image;
+
+bool is_ktx2_path(std::string const &path);
+// block layout of the formats we read and write, false when unsupported
+bool ktx2_block_info(VkFormat format, uint32_t &block_extent,
+                     uint32_t &block_bytes);
+// reads only the header
+VkFormat peek_ktx2_format(std::string const &path);
+Ktx2Image load_ktx2(std::string const &path);
+// writes a basic data format descriptor, levels stored smallest first
+void write_ktx2(std::string const &path, Ktx2Image const &image);
+
+#endif  // VK_TUTORIAL_KTX2_H
@@ -1,16 +1,150 @@
-
+#include <cstring>
 #include <iostream>
+#include <string>
 
+#include "cpu_trace.h"
 #include "vulkan_app.h"
 
+static void print_usage(char const* program) {
+    std::cerr << "usage: " << program
+              << " [--frames-in-flight N] [--objects N] [--record-threads N]"
+                 " [--record-benchmark] [--headless] [--frames N]\n"
+                 "       [--benchmark] [--warmup N] [--bench-frames N]"
+                 " [--report FILE.json|FILE.csv]\n"
+                 "       [--gpu-trace FILE.json] [--trace FILE.json]"
+                 " [--serial-init] [--mipmaps blit|cpu|off]\n"
+                 "       [--texture FILE.jpg|FILE.ktx2] [--assets FILE.pack]"
+                 " [--mesh FILE.obj]...\n"
+                 "       [--render-mode per-object|instanced|indirect]"
+                 " [--gpu-culling] [--cpu-culling] [--spread F]\n";
+}
+
+static AppOptions parse_options(int argc, char** argv) {
+    AppOptions options;
+    for (int i = 1; i < argc; ++i) {
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error(std::string("missing value for ") +
+                                         argv[i]);
+            }
+            return argv[++i];
+        };
+        if (std::strcmp(argv[i], "--frames-in-flight") == 0) {
+            options.frames_in_flight = (uint32_t)std::stoul(value());
+        } else if (std::strcmp(argv[i], "--objects") == 0) {
+            options.object_count = (uint32_t)std::stoul(value());
+        } else if (std::strcmp(argv[i], "--record-threads") == 0) {
+            options.record_threads = (uint32_t)std::stoul(value());
+        } else if (std::strcmp(argv[i], "--record-benchmark") == 0) {
+            options.record_benchmark = true;
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            options.headless = true;
+        } else if (std::strcmp(argv[i], "--frames") == 0) {
+            options.frame_limit = (uint32_t)std::stoul(value());
+        } else if (std::strcmp(argv[i], "--benchmark") == 0) {
+            options.benchmark = true;
+        } else if (std::strcmp(argv[i], "--warmup") == 0) {
+            options.warmup_frames = (uint32_t)std::stoul(value());
+        } else if (std::strcmp(argv[i], "--bench-frames") == 0) {
+            options.benchmark_frames = (uint32_t)std::stoul(value());
+        } else if (std::strcmp(argv[i], "--report") == 0) {
+            options.report_path = value();
+            options.benchmark = true;
+        } else if (std::strcmp(argv[i], "--gpu-trace") == 0) {
+            options.gpu_trace_path = value();
+        } else if (std::strcmp(argv[i], "--trace") == 0) {
+            options.trace_path = value();
+        } else if (std::strcmp(argv[i], "--serial-init") == 0) {
+            options.serial_init = true;
+        } else if (std::strcmp(argv[i], "--mipmaps") == 0) {
+            auto mode = value();
+            if (mode == "blit") {
+                options.mip_generation = MIP_GENERATION_BLIT;
+            } else if (mode == "cpu") {
+                options.mip_generation = MIP_GENERATION_CPU;
+            } else if (mode == "off") {
+                options.mip_generation = MIP_GENERATION_NONE;
+            } else {
+                throw std::runtime_error("unknown mipmap mode " + mode);
+            }
+        } else if (std::strcmp(argv[i], "--texture") == 0) {
+            options.texture_path = value();
+        } else if (std::strcmp(argv[i], "--assets") == 0) {
+            options.asset_pack_path = value();
+        } else if (std::strcmp(argv[i], "--mesh") == 0) {
+            options.mesh_paths.push_back(value());
+        } else if (std::strcmp(argv[i], "--render-mode") == 0) {
+            auto mode = value();
+            if (mode == "per-object") {
+                options.render_mode = RENDER_MODE_PER_OBJECT;
+            } else if (mode == "instanced") {
+                options.render_mode = RENDER_MODE_INSTANCED;
+            } else if (mode == "indirect") {
+                options.render_mode = RENDER_MODE_INDIRECT;
+            } else {
+                throw std::runtime_error("unknown render mode " + mode);
+            }
+        } else if (std::strcmp(argv[i], "--gpu-culling") == 0) {
+            options.gpu_culling = true;
+        } else if (std::strcmp(argv[i], "--cpu-culling") == 0) {
+            options.cpu_culling = true;
+        } else if (std::strcmp(argv[i], "--spread") == 0) {
+            options.scene_spread = std::stof(value());
+        } else {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        }
+    }
+    // headless runs have no window to close, they need a frame budget
+    if (options.headless && options.frame_limit == 0 && !options.benchmark) {
+        throw std::runtime_error(
+            "--headless requires --frames N or --benchmark");
+    }
+    // culling compacts the indirect command buffer, nothing else to cull
+    if (options.gpu_culling && options.render_mode != RENDER_MODE_INDIRECT) {
+        throw std::runtime_error(
+            "--gpu-culling requires --render-mode indirect");
+    }
+    // the other modes draw every instance, only per-object draws can be
+    // skipped from the host
+    if (options.cpu_culling && options.render_mode != RENDER_MODE_PER_OBJECT) {
+        throw std::runtime_error(
+            "--cpu-culling requires --render-mode per-object");
+    }
+    return options;
+}
+
 int main(int argc, char** argv) {
-    VulkanApplication app;
+    AppOptions options;
     try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // tracing starts before the window so startup is covered too
+    CpuTrace::enable(!options.trace_path.empty());
+    if (CpuTrace::is_enabled()) {
+        CpuTrace::set_thread_name("main");
+    }
+    try {
+        VulkanApplication app(options);
         app.run();
     } catch (const std::exception& e) {
         std::cerr << e.what() << '\n';
         return EXIT_FAILURE;
     }
 
+    if (!options.trace_path.empty()) {
+        try {
+            CpuTrace::write_chrome_trace(options.trace_path);
+            std::cout << "cpu trace written to " << options.trace_path << '\n';
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,184 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "mesh_registry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "cpu_trace.h"
+#include "obj_loader.h"
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// center of the bounding box and the farthest vertex from it, a little
+// looser than the minimal sphere but a single pass
+static void compute_bounds(Vertex const *vertices, uint32_t vertex_count,
+                           float bounds[4]) {
+    if (vertex_count == 0) {
+        return;
+    }
+    Eigen::Vector3f lo = vertices[0].pos, hi = vertices[0].pos;
+    for (uint32_t i = 1; i < vertex_count; ++i) {
+        lo = lo.cwiseMin(vertices[i].pos);
+        hi = hi.cwiseMax(vertices[i].pos);
+    }
+    Eigen::Vector3f center = (lo + hi) * 0.5f;
+    float radius_squared = 0.0f;
+    for (uint32_t i = 0; i < vertex_count; ++i) {
+        radius_squared =
+            std::max(radius_squared, (vertices[i].pos - center).squaredNorm());
+    }
+    bounds[0] = center.x();
+    bounds[1] = center.y();
+    bounds[2] = center.z();
+    bounds[3] = std::sqrt(radius_squared);
+}
+
+MeshRegistry::Mesh &MeshRegistry::place(std::string name,
+                                        uint32_t vertex_count,
+                                        uint32_t index_count, bool narrow) {
+    if (vertex_total + vertex_count >
+        (uint64_t)std::numeric_limits<int32_t>::max()) {
+        throw std::runtime_error("mesh registry vertex space exhausted!");
+    }
+    uint32_t index_size = narrow ? 2 : 4;
+    // 4 byte aligned starts keep first_index exact for either width
+    index_byte_total = (index_byte_total + 3) / 4 * 4;
+
+    Mesh mesh{.name = std::move(name)};
+    mesh.range = MeshRange{
+        .first_index = (uint32_t)(index_byte_total / index_size),
+        .index_count = index_count,
+        .vertex_offset = (int32_t)vertex_total,
+        .vertex_count = vertex_count,
+        .index_type = narrow ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32};
+    vertex_total += vertex_count;
+    index_byte_total += (uint64_t)index_count * index_size;
+
+    ++counters.mesh_count;
+    counters.narrow_meshes += narrow ? 1 : 0;
+    counters.vertex_count += vertex_count;
+    counters.triangle_count += index_count / 3;
+    counters.vertex_bytes += (uint64_t)vertex_count * sizeof(Vertex);
+    counters.index_bytes += (uint64_t)index_count * index_size;
+    meshes.push_back(std::move(mesh));
+    return meshes.back();
+}
+
+uint32_t MeshRegistry::add(std::string name, Vertex const *vertices,
+                           uint32_t vertex_count, uint32_t const *indices,
+                           uint32_t index_count) {
+    bool narrow = vertex_count <= 65536;
+    auto &mesh = place(std::move(name), vertex_count, index_count, narrow);
+    mesh.vertex_storage.resize((size_t)vertex_count * sizeof(Vertex));
+    memcpy(mesh.vertex_storage.data(), vertices, mesh.vertex_storage.size());
+    if (narrow) {
+        mesh.index_storage.resize((size_t)index_count * sizeof(uint16_t));
+        auto narrowed = reinterpret_cast<uint16_t *>(mesh.index_storage.data());
+        for (uint32_t i = 0; i < index_count; ++i) {
+            narrowed[i] = (uint16_t)indices[i];
+        }
+    } else {
+        mesh.index_storage.resize((size_t)index_count * sizeof(uint32_t));
+        memcpy(mesh.index_storage.data(), indices, mesh.index_storage.size());
+    }
+    mesh.vertex_data = mesh.vertex_storage.data();
+    mesh.index_data = mesh.index_storage.data();
+    compute_bounds(vertices, vertex_count, mesh.range.bounds);
+    return (uint32_t)meshes.size() - 1;
+}
+
+uint32_t MeshRegistry::add_packed(std::string name, MeshView const &view) {
+    auto const &header = view.header;
+    if (header.vertex_stride != sizeof(Vertex) ||
+        (header.index_size != 2 && header.index_size != 4)) {
+        throw std::runtime_error("asset pack mesh layout mismatch! " + name);
+    }
+    auto &mesh = place(std::move(name), header.vertex_count,
+                       header.index_count, header.index_size == 2);
+    mesh.vertex_data = view.vertices;
+    mesh.index_data = view.indices;
+    compute_bounds(static_cast<Vertex const *>(view.vertices),
+                   header.vertex_count, mesh.range.bounds);
+    return (uint32_t)meshes.size() - 1;
+}
+
+uint32_t MeshRegistry::load_obj(std::string const &path) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    ::load_obj(path, vertices, indices);
+    auto id = add(path, vertices.data(), (uint32_t)vertices.size(),
+                  indices.data(), (uint32_t)indices.size());
+    counters.load_ms += elapsed_ms(start);
+    return id;
+}
+
+uint32_t MeshRegistry::find(std::string const &name) const {
+    for (uint32_t i = 0; i < meshes.size(); ++i) {
+        if (meshes[i].name == name) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+VkDeviceSize MeshRegistry::vertex_bytes() const {
+    return (VkDeviceSize)vertex_total * sizeof(Vertex);
+}
+
+VkDeviceSize MeshRegistry::index_bytes() const {
+    // never hand out a zero sized buffer
+    return std::max<VkDeviceSize>(index_byte_total, 4);
+}
+
+void MeshRegistry::upload(StagingUploader &uploader, VkBuffer vertex_buffer,
+                          VkBuffer index_buffer) {
+    CPU_ZONE_FUNCTION();
+    auto start = std::chrono::steady_clock::now();
+    for (auto &mesh : meshes) {
+        auto const &range = mesh.range;
+        if (!mesh.vertex_data) {
+            continue;  // already uploaded
+        }
+        VkDeviceSize index_size =
+            range.index_type == VK_INDEX_TYPE_UINT16 ? 2 : 4;
+        uploader.upload_buffer(
+            vertex_buffer, (VkDeviceSize)range.vertex_offset * sizeof(Vertex),
+            mesh.vertex_data,
+            (VkDeviceSize)range.vertex_count * sizeof(Vertex));
+        uploader.upload_buffer(index_buffer, range.first_index * index_size,
+                               mesh.index_data, range.index_count * index_size);
+        mesh.vertex_data = mesh.index_data = nullptr;
+        mesh.vertex_storage = {};
+        mesh.index_storage = {};
+    }
+    counters.upload_ms += elapsed_ms(start);
+}
+
+void MeshRegistry::clear() {
+    meshes.clear();
+    vertex_total = index_byte_total = 0;
+    counters = MeshStats{};
+}
+
+MeshStats MeshRegistry::stats() const { return counters; }
+
+void MeshRegistry::print_stats(std::ostream &os) const {
+    auto s = stats();
+    auto to_mib = [](uint64_t bytes) { return bytes / (1024.0 * 1024.0); };
+    os << "meshes: " << s.mesh_count << " (" << s.narrow_meshes
+       << " with 16-bit indices), " << s.vertex_count << " vertices, "
+       << s.triangle_count << " triangles, " << to_mib(s.vertex_bytes)
+       << " MiB vertices, " << to_mib(s.index_bytes) << " MiB indices, "
+       << s.load_ms << " ms loading, " << s.upload_ms << " ms staging\n";
+}
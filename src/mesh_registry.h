@@ -0,0 +1,92 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_MESH_REGISTRY_H
+#define VK_TUTORIAL_MESH_REGISTRY_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "asset_pack.h"
+#include "staging_uploader.h"
+#include "vertex.h"
+
+// Where a mesh lives inside the shared vertex/index buffers. Bind the index
+// buffer at offset 0 with index_type, first_index is counted in that type.
+typedef struct MeshRange {
+    uint32_t first_index{0};
+    uint32_t index_count{0};
+    int32_t vertex_offset{0};  // added to every index by the draw
+    uint32_t vertex_count{0};
+    VkIndexType index_type{VK_INDEX_TYPE_UINT16};
+    float bounds[4]{0.0f, 0.0f, 0.0f, 0.0f};  // sphere center xyz, radius
+} MeshRange;
+
+typedef struct MeshStats {
+    uint32_t mesh_count{0};
+    uint32_t narrow_meshes{0};  // stored with 16-bit indices
+    uint64_t vertex_count{0};
+    uint64_t triangle_count{0};
+    uint64_t vertex_bytes{0};
+    uint64_t index_bytes{0};
+    double load_ms{0.0};    // parsing / converting on the CPU
+    double upload_ms{0.0};  // memcpy into the staging ring
+} MeshStats;
+
+// Every mesh is packed into one big vertex buffer and one big index buffer
+// and addressed by a MeshRange, so switching meshes never rebinds vertex
+// data. Meshes with at most 65536 vertices store 16-bit indices, larger ones
+// 32-bit; starts are 4 byte aligned so both widths can share the buffer.
+// Meshes are added on the CPU first (before the device exists if need be),
+// then upload() stages everything into caller owned buffers.
+class MeshRegistry {
+   public:
+    uint32_t add(std::string name, Vertex const *vertices,
+                 uint32_t vertex_count, uint32_t const *indices,
+                 uint32_t index_count);
+    // keeps pointing into the mapped pack until upload()
+    uint32_t add_packed(std::string name, MeshView const &view);
+    // see load_obj() in obj_loader.h
+    uint32_t load_obj(std::string const &path);
+
+    // returns UINT32_MAX when missing
+    uint32_t find(std::string const &name) const;
+    MeshRange const &mesh(uint32_t id) const { return meshes[id].range; }
+    uint32_t size() const { return (uint32_t)meshes.size(); }
+    VkDeviceSize vertex_bytes() const;
+    VkDeviceSize index_bytes() const;
+
+    // copies every mesh to its range, then drops the CPU side data
+    void upload(StagingUploader &uploader, VkBuffer vertex_buffer,
+                VkBuffer index_buffer);
+    void clear();
+
+    MeshStats stats() const;
+    void print_stats(std::ostream &os) const;
+
+   private:
+    typedef struct Mesh {
+        std::string name;
+        MeshRange range;
+        // either point into the storage vectors or into an asset pack
+        void const *vertex_data{nullptr};
+        void const *index_data{nullptr};
+        std::vector<unsigned char> vertex_storage;
+        std::vector<unsigned char> index_storage;
+    } Mesh;
+
+    std::vector<Mesh> meshes;
+    uint64_t vertex_total{0};      // vertices placed so far
+    uint64_t index_byte_total{0};  // bytes of indices placed so far
+    MeshStats counters;
+
+    Mesh &place(std::string name, uint32_t vertex_count,
+                uint32_t index_count, bool narrow);
+};
+
+#endif  // VK_TUTORIAL_MESH_REGISTRY_H
@@ -0,0 +1,162 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "obj_loader.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "cpu_trace.h"
+
+typedef struct ObjKey {
+    int position, tex_coord, normal;
+    bool operator==(ObjKey const &other) const {
+        return position == other.position && tex_coord == other.tex_coord &&
+               normal == other.normal;
+    }
+} ObjKey;
+
+typedef struct ObjKeyHash {
+    size_t operator()(ObjKey const &key) const {
+        return ((size_t)key.position * 73856093u) ^
+               ((size_t)key.tex_coord * 19349663u) ^
+               ((size_t)key.normal * 83492791u);
+    }
+} ObjKeyHash;
+
+// OBJ indices are 1 based, negative ones count back from the newest element
+static int resolve_obj_index(long index, size_t count) {
+    if (index < 0) {
+        index += (long)count + 1;
+    }
+    return index >= 1 && (size_t)index <= count ? (int)index - 1 : -1;
+}
+
+void load_obj(std::string const &path, std::vector<Vertex> &vertices,
+              std::vector<uint32_t> &indices) {
+    CPU_ZONE_FUNCTION();
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open file! " + path);
+    }
+    std::string text((size_t)file.tellg(), '\0');
+    file.seekg(0);
+    file.read(text.data(), (std::streamsize)text.size());
+
+    std::vector<Eigen::Vector3f> positions, normals;
+    std::vector<Eigen::Vector2f> tex_coords;
+    vertices.clear();
+    indices.clear();
+    std::unordered_map<ObjKey, uint32_t, ObjKeyHash> vertex_ids;
+    std::vector<uint32_t> polygon;
+
+    char const *cursor = text.c_str();
+    char *next = nullptr;
+    uint32_t line = 1;
+    auto invalid_index = [&]() {
+        return std::runtime_error("invalid OBJ face index! " + path + ":" +
+                                  std::to_string(line));
+    };
+    auto skip_spaces = [&]() {
+        while (*cursor == ' ' || *cursor == '\t') {
+            ++cursor;
+        }
+    };
+    auto read_float = [&]() {
+        auto value = std::strtof(cursor, &next);
+        cursor = next;
+        return value;
+    };
+    while (*cursor) {
+        skip_spaces();
+        if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            ++cursor;
+            float x = read_float(), y = read_float(), z = read_float();
+            positions.emplace_back(x, y, z);
+        } else if (cursor[0] == 'v' && cursor[1] == 't') {
+            cursor += 2;
+            float u = read_float(), v = read_float();
+            tex_coords.emplace_back(u, v);
+        } else if (cursor[0] == 'v' && cursor[1] == 'n') {
+            cursor += 2;
+            float x = read_float(), y = read_float(), z = read_float();
+            normals.emplace_back(x, y, z);
+        } else if (cursor[0] == 'f' &&
+                   (cursor[1] == ' ' || cursor[1] == '\t')) {
+            ++cursor;
+            polygon.clear();
+            while (true) {
+                skip_spaces();
+                if (*cursor == '\0' || *cursor == '\n' || *cursor == '\r' ||
+                    *cursor == '#') {
+                    break;
+                }
+                // v, v/vt, v//vn or v/vt/vn
+                ObjKey key{-1, -1, -1};
+                key.position = resolve_obj_index(
+                    std::strtol(cursor, &next, 10), positions.size());
+                cursor = next;
+                if (*cursor == '/') {
+                    ++cursor;
+                    if (*cursor != '/') {
+                        key.tex_coord = resolve_obj_index(
+                            std::strtol(cursor, &next, 10), tex_coords.size());
+                        cursor = next;
+                        if (key.tex_coord < 0) {
+                            throw invalid_index();
+                        }
+                    }
+                    if (*cursor == '/') {
+                        ++cursor;
+                        key.normal = resolve_obj_index(
+                            std::strtol(cursor, &next, 10), normals.size());
+                        cursor = next;
+                        if (key.normal < 0) {
+                            throw invalid_index();
+                        }
+                    }
+                }
+                if (key.position < 0) {
+                    throw invalid_index();
+                }
+                auto [it, inserted] =
+                    vertex_ids.try_emplace(key, (uint32_t)vertices.size());
+                if (inserted) {
+                    Vertex vertex{.pos = positions[key.position],
+                                  .color = Eigen::Vector3f::Ones(),
+                                  .tex_coord = Eigen::Vector2f::Zero()};
+                    if (key.tex_coord >= 0) {
+                        // OBJ puts v = 0 at the bottom, Vulkan at the top
+                        auto const &uv = tex_coords[key.tex_coord];
+                        vertex.tex_coord = {uv.x(), 1.0f - uv.y()};
+                    }
+                    if (key.normal >= 0) {
+                        vertex.color = normals[key.normal] * 0.5f +
+                                       Eigen::Vector3f::Constant(0.5f);
+                    }
+                    vertices.push_back(vertex);
+                }
+                polygon.push_back(it->second);
+            }
+            // fan triangulation, fine for the convex faces exporters write
+            for (size_t i = 2; i < polygon.size(); ++i) {
+                indices.push_back(polygon[0]);
+                indices.push_back(polygon[i - 1]);
+                indices.push_back(polygon[i]);
+            }
+        }
+        // skip the rest of the line (comments, groups, materials, ...)
+        while (*cursor && *cursor != '\n') {
+            ++cursor;
+        }
+        if (*cursor == '\n') {
+            ++cursor;
+            ++line;
+        }
+    }
+    if (indices.empty()) {
+        throw std::runtime_error("OBJ file has no faces! " + path);
+    }
+}
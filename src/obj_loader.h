@@ -0,0 +1,21 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_OBJ_LOADER_H
+#define VK_TUTORIAL_OBJ_LOADER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "vertex.h"
+
+// Wavefront OBJ geometry only (v/vt/vn/f, materials and groups ignored).
+// Polygons are fan triangulated, vertices deduplicated per position/uv/
+// normal triple, uv flipped to Vulkan's top-left origin and normals stored
+// in the color attribute. Throws on unreadable files or broken faces.
+void load_obj(std::string const &path, std::vector<Vertex> &vertices,
+              std::vector<uint32_t> &indices);
+
+#endif  // VK_TUTORIAL_OBJ_LOADER_H
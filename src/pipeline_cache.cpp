@@ -0,0 +1,169 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "pipeline_cache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+static const uint32_t CACHE_FILE_MAGIC = 0x43505456;  // "VTPC"
+static const uint32_t CACHE_FILE_VERSION = 1;
+
+static uint64_t fnv1a(char const *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (uint8_t)data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void PipelineCache::init(VkPhysicalDevice physical_device, VkDevice device,
+                         std::string path) {
+    this->device = device;
+    this->path = std::move(path);
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    auto file = load_file();
+    std::vector<char> data;
+    if (file.size() >= sizeof(FileHeader)) {
+        FileHeader header;
+        std::memcpy(&header, file.data(), sizeof(FileHeader));
+        data.assign(file.begin() + sizeof(FileHeader), file.end());
+        if (!is_compatible(header, data)) {
+            std::cout << "pipeline cache: " << this->path
+                      << " is stale or corrupt, starting cold\n";
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo create_info{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data()};
+
+    if (vkCreatePipelineCache(device, &create_info, nullptr, &cache) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+    warm = !data.empty();
+    loaded_bytes = data.size();
+    loaded_checksum = warm ? fnv1a(data.data(), data.size()) : 0;
+}
+
+std::vector<char> PipelineCache::load_file() const {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        return {};  // first run, nothing cached yet
+    }
+    auto file_size = static_cast<size_t>(file.tellg());
+    std::vector<char> buffer(file_size);
+    file.seekg(0);
+    file.read(buffer.data(), file_size);
+    if (!file) {
+        return {};
+    }
+    return buffer;
+}
+
+bool PipelineCache::is_compatible(FileHeader const &header,
+                                  std::vector<char> const &data) const {
+    if (header.magic != CACHE_FILE_MAGIC ||
+        header.version != CACHE_FILE_VERSION ||
+        header.data_size != data.size() ||
+        header.checksum != fnv1a(data.data(), data.size())) {
+        return false;
+    }
+    // the driver blob carries its own identity, a mismatch on either side
+    // means another GPU or driver produced it
+    if (header.vendor_id != properties.vendorID ||
+        header.device_id != properties.deviceID ||
+        header.driver_version != properties.driverVersion ||
+        std::memcmp(header.pipeline_cache_uuid, properties.pipelineCacheUUID,
+                    VK_UUID_SIZE) != 0) {
+        return false;
+    }
+    if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne)) {
+        return false;
+    }
+    VkPipelineCacheHeaderVersionOne driver_header;
+    std::memcpy(&driver_header, data.data(), sizeof(driver_header));
+    return driver_header.headerSize >= sizeof(driver_header) &&
+           driver_header.headerVersion ==
+               VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           driver_header.vendorID == properties.vendorID &&
+           driver_header.deviceID == properties.deviceID &&
+           std::memcmp(driver_header.pipelineCacheUUID,
+                       properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void PipelineCache::save() {
+    if (cache == VK_NULL_HANDLE) {
+        return;
+    }
+    size_t data_size = 0;
+    if (vkGetPipelineCacheData(device, cache, &data_size, nullptr) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to query pipeline cache size!");
+    }
+    std::vector<char> data(data_size);
+    if (vkGetPipelineCacheData(device, cache, &data_size, data.data()) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to read pipeline cache data!");
+    }
+    data.resize(data_size);
+
+    auto checksum = fnv1a(data.data(), data.size());
+    if (warm && data.size() == loaded_bytes && checksum == loaded_checksum) {
+        return;  // nothing new was compiled this run
+    }
+
+    FileHeader header{.magic = CACHE_FILE_MAGIC,
+                      .version = CACHE_FILE_VERSION,
+                      .data_size = data.size(),
+                      .checksum = checksum,
+                      .vendor_id = properties.vendorID,
+                      .device_id = properties.deviceID,
+                      .driver_version = properties.driverVersion,
+                      .reserved = 0};
+    std::memcpy(header.pipeline_cache_uuid, properties.pipelineCacheUUID,
+                VK_UUID_SIZE);
+
+    // write next to the target, then swap it in with a single rename
+    auto tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "pipeline cache: failed to open " << tmp_path << '\n';
+            return;
+        }
+        file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        file.write(data.data(), (std::streamsize)data.size());
+        file.flush();
+        if (!file) {
+            std::cerr << "pipeline cache: failed to write " << tmp_path
+                      << '\n';
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::cerr << "pipeline cache: failed to replace " << path << ": "
+                  << ec.message() << '\n';
+        std::filesystem::remove(tmp_path, ec);
+        return;
+    }
+    std::cout << "pipeline cache: saved " << data.size() << " bytes to "
+              << path << '\n';
+}
+
+void PipelineCache::destroy() {
+    if (cache != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(device, cache, nullptr);
+        cache = VK_NULL_HANDLE;
+    }
+}
@@ -0,0 +1,61 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_PIPELINE_CACHE_H
+#define VK_TUTORIAL_PIPELINE_CACHE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// VkPipelineCache backed by a file on disk. The blob written by the driver is
+// prefixed with our own header (device identity + checksum) so a cache from
+// another GPU, driver version or a truncated write is dropped instead of
+// being fed back into vkCreatePipelineCache. save() writes to a temporary
+// file and renames it over the old one, a crash never leaves half a cache.
+class PipelineCache {
+   public:
+    static constexpr const char *DEFAULT_PATH = "pipeline_cache.bin";
+
+    void init(VkPhysicalDevice physical_device, VkDevice device,
+              std::string path = DEFAULT_PATH);
+    // write the current cache contents back to disk if they changed
+    void save();
+    void destroy();
+
+    VkPipelineCache handle() const { return cache; }
+    // true when init() found a valid cache file for this device
+    bool is_warm() const { return warm; }
+    size_t loaded_size() const { return loaded_bytes; }
+
+   private:
+    typedef struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t data_size;
+        uint64_t checksum;  // FNV-1a over the driver blob
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint32_t driver_version;
+        uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+        uint32_t reserved;  // spells out the tail padding, written as 0
+    } FileHeader;
+    static_assert(sizeof(FileHeader) == 56, "cache header must be packed");
+
+    VkDevice device{VK_NULL_HANDLE};
+    VkPipelineCache cache{VK_NULL_HANDLE};
+    VkPhysicalDeviceProperties properties{};
+    std::string path;
+    bool warm{false};
+    size_t loaded_bytes{0};
+    uint64_t loaded_checksum{0};
+
+    std::vector<char> load_file() const;
+    bool is_compatible(FileHeader const &header,
+                       std::vector<char> const &data) const;
+};
+
+#endif  // VK_TUTORIAL_PIPELINE_CACHE_H
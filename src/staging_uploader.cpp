@@ -0,0 +1,403 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "staging_uploader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+    if (alignment <= 1) {
+        return value;
+    }
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void StagingUploader::init(VkDevice device, DeviceAllocator *allocator,
+                           VkQueue queue, uint32_t queue_family,
+                           VkDeviceSize ring_size) {
+    this->device = device;
+    this->allocator = allocator;
+    this->queue = queue;
+    this->queue_family = queue_family;
+    this->ring_size = ring_size;
+
+    VkCommandPoolCreateInfo pool_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+                 VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queue_family};
+    if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload command pool!");
+    }
+
+    batches.resize(MAX_BATCHES);
+    std::vector<VkCommandBuffer> command_buffers(MAX_BATCHES);
+    VkCommandBufferAllocateInfo alloc_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = command_pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = MAX_BATCHES};
+    if (vkAllocateCommandBuffers(device, &alloc_info,
+                                 command_buffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate upload command buffers!");
+    }
+
+    for (uint32_t i = 0; i < MAX_BATCHES; ++i) {
+        batches[i].command_buffer = command_buffers[i];
+    }
+
+    // batch N signals value N, so a ticket is directly a timeline value
+    VkSemaphoreTypeCreateInfo timeline_info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0};
+    VkSemaphoreCreateInfo semaphore_info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timeline_info};
+    if (vkCreateSemaphore(device, &semaphore_info, nullptr, &timeline) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload timeline!");
+    }
+
+    create_staging_buffer(ring_size, ring_buffer, ring_allocation);
+}
+
+void StagingUploader::destroy() {
+    flush();
+    while (wait_oldest()) {
+    }
+    batches.clear();
+    vkDestroySemaphore(device, timeline, nullptr);
+    vkDestroyCommandPool(device, command_pool, nullptr);
+    vkDestroyBuffer(device, ring_buffer, nullptr);
+    allocator->free(ring_allocation);
+}
+
+void StagingUploader::create_staging_buffer(VkDeviceSize size,
+                                            VkBuffer &buffer,
+                                            Allocation &allocation) {
+    // staging memory is only ever touched by the upload queue
+    VkBufferCreateInfo buffer_info{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE};
+    if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create staging buffer!");
+    }
+
+    VkMemoryRequirements mem_requirements;
+    vkGetBufferMemoryRequirements(device, buffer, &mem_requirements);
+    allocation = allocator->allocate(
+        mem_requirements,
+        allocator->find_memory_type(mem_requirements.memoryTypeBits,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+        true);
+    vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+}
+
+VkCommandBuffer StagingUploader::command_buffer() {
+    auto &batch = batches[current];
+    if (!batch.recording) {
+        // the slot is reused round-robin, so a submitted one is the oldest
+        if (batch.submitted) {
+            wait_value(batch.ticket);
+            retire(batch);
+        }
+        vkResetCommandBuffer(batch.command_buffer, 0);
+        VkCommandBufferBeginInfo begin_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+        if (vkBeginCommandBuffer(batch.command_buffer, &begin_info) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to begin upload command buffer!");
+        }
+        if (profiler) {
+            // the slot was waited on above, so its last zone is resolvable
+            profiler->begin_frame(current, next_ticket);
+            batch.zone =
+                profiler->begin_zone(batch.command_buffer, "upload batch");
+        }
+        batch.recording = true;
+        batch.ticket = next_ticket;
+        batch.ring_bytes = 0;
+    }
+    return batch.command_buffer;
+}
+
+bool StagingUploader::try_reserve(VkDeviceSize size, VkDeviceSize alignment,
+                                  VkDeviceSize &offset) {
+    if (used == 0) {
+        head = tail = 0;
+    }
+    VkDeviceSize start = align_up(head, alignment);
+    VkDeviceSize consumed;
+    if (used == 0 || tail < head) {
+        // free space is [head, ring_size) followed by [0, tail)
+        if (start + size <= ring_size) {
+            consumed = start + size - head;
+        } else if (size <= tail) {
+            start = 0;
+            consumed = ring_size - head + size;
+        } else {
+            return false;
+        }
+    } else {
+        // wrapped: free space is [head, tail)
+        if (start + size > tail) {
+            return false;
+        }
+        consumed = start + size - head;
+    }
+
+    auto &batch = batches[current];
+    offset = start;
+    head = start + size;
+    used += consumed;
+    batch.ring_bytes += consumed;
+    batch.ring_end = head;
+    return true;
+}
+
+StagingSpan StagingUploader::reserve(VkDeviceSize size,
+                                     VkDeviceSize alignment) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    command_buffer();
+
+    VkDeviceSize offset;
+    while (!try_reserve(size, alignment, offset)) {
+        if (wait_oldest()) {
+            continue;
+        }
+        // nothing in flight, but the batch being recorded holds the ring
+        if (batches[current].ring_bytes > 0) {
+            flush();
+            command_buffer();
+            continue;
+        }
+        // larger than the whole ring, give it a buffer of its own
+        StagingSpan span{.size = size};
+        std::pair<VkBuffer, Allocation> temporary;
+        create_staging_buffer(size, temporary.first, temporary.second);
+        span.data = temporary.second.mapped;
+        span.buffer = temporary.first;
+        batches[current].temporaries.push_back(temporary);
+        return span;
+    }
+
+    return StagingSpan{
+        .data = static_cast<char *>(ring_allocation.mapped) + offset,
+        .buffer = ring_buffer,
+        .offset = offset,
+        .size = size};
+}
+
+void StagingUploader::copy_to_buffer(StagingSpan const &span, VkBuffer dst,
+                                     VkDeviceSize dst_offset) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    VkBufferCopy copy_region{
+        .srcOffset = span.offset, .dstOffset = dst_offset, .size = span.size};
+    vkCmdCopyBuffer(command_buffer(), span.buffer, dst, 1, &copy_region);
+}
+
+static VkDeviceSize level_size(uint32_t width, uint32_t height,
+                               ImageLevels const &levels, uint32_t level) {
+    auto blocks = [&](uint32_t extent) {
+        extent = std::max(extent >> level, 1u);
+        return (VkDeviceSize)(extent + levels.block_extent - 1) /
+               levels.block_extent;
+    };
+    return blocks(width) * blocks(height) * levels.block_bytes;
+}
+
+VkDeviceSize StagingUploader::image_size(uint32_t width, uint32_t height,
+                                         ImageLevels const &levels) {
+    VkDeviceSize size = 0;
+    for (uint32_t level = 0; level < levels.provided; ++level) {
+        size += level_size(width, height, levels, level);
+    }
+    return size;
+}
+
+void StagingUploader::copy_to_image(StagingSpan const &span, VkImage dst,
+                                    uint32_t width, uint32_t height,
+                                    ImageLevels const &levels) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto cmd = command_buffer();
+
+    VkImageMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = dst,
+        .subresourceRange{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                          .baseMipLevel = 0,
+                          .levelCount = levels.total,
+                          .baseArrayLayer = 0,
+                          .layerCount = 1}};
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &barrier);
+
+    // one region per provided level, packed back to back in the span
+    std::vector<VkBufferImageCopy> regions(levels.provided);
+    VkDeviceSize offset = span.offset;
+    for (uint32_t level = 0; level < levels.provided; ++level) {
+        regions[level] = VkBufferImageCopy{
+            .bufferOffset = offset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                              .mipLevel = level,
+                              .baseArrayLayer = 0,
+                              .layerCount = 1},
+            .imageOffset{0, 0, 0},
+            .imageExtent{std::max(width >> level, 1u),
+                         std::max(height >> level, 1u), 1}};
+        offset += level_size(width, height, levels, level);
+    }
+    vkCmdCopyBufferToImage(cmd, span.buffer, dst,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           (uint32_t)regions.size(), regions.data());
+
+    if (levels.final_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        return;
+    }
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = levels.final_layout;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+}
+
+void StagingUploader::upload_buffer(VkBuffer dst, VkDeviceSize dst_offset,
+                                    void const *data, VkDeviceSize size) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto span = reserve(size);
+    memcpy(span.data, data, (size_t)size);
+    copy_to_buffer(span, dst, dst_offset);
+}
+
+void StagingUploader::upload_image(VkImage dst, uint32_t width, uint32_t height,
+                                   void const *data, VkDeviceSize size,
+                                   ImageLevels const &levels) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto span = reserve(size);
+    memcpy(span.data, data, (size_t)size);
+    copy_to_image(span, dst, width, height, levels);
+}
+
+uint64_t StagingUploader::flush() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto &batch = batches[current];
+    if (!batch.recording) {
+        return 0;
+    }
+    if (profiler) {
+        profiler->end_zone(batch.command_buffer, batch.zone);
+    }
+    vkEndCommandBuffer(batch.command_buffer);
+
+    VkTimelineSemaphoreSubmitInfo timeline_info{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues = &batch.ticket};
+    VkSubmitInfo submit_info{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                             .pNext = &timeline_info,
+                             .commandBufferCount = 1,
+                             .pCommandBuffers = &batch.command_buffer,
+                             .signalSemaphoreCount = 1,
+                             .pSignalSemaphores = &timeline};
+    if (vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit upload batch!");
+    }
+    batch.recording = false;
+    batch.submitted = true;
+    ++next_ticket;
+    current = (current + 1) % MAX_BATCHES;
+    return batch.ticket;
+}
+
+uint64_t StagingUploader::pending_ticket() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return batches[current].recording ? next_ticket : next_ticket - 1;
+}
+
+bool StagingUploader::is_complete(uint64_t ticket) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    poll();
+    return ticket <= completed_ticket;
+}
+
+void StagingUploader::wait(uint64_t ticket) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (batches[current].recording && batches[current].ticket <= ticket) {
+        flush();
+    }
+    while (completed_ticket < ticket && wait_oldest()) {
+    }
+}
+
+bool StagingUploader::wait_oldest() {
+    // submitted slots form a run that starts at the oldest batch
+    for (uint32_t k = 0; k < MAX_BATCHES; ++k) {
+        auto &batch = batches[(current + k) % MAX_BATCHES];
+        if (batch.submitted) {
+            wait_value(batch.ticket);
+            retire(batch);
+            return true;
+        }
+    }
+    return false;
+}
+
+void StagingUploader::wait_value(uint64_t value) {
+    VkSemaphoreWaitInfo wait_info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &timeline,
+        .pValues = &value};
+    if (vkWaitSemaphores(device, &wait_info, UINT64_MAX) != VK_SUCCESS) {
+        throw std::runtime_error("failed to wait for upload timeline!");
+    }
+}
+
+void StagingUploader::poll() {
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(device, timeline, &value);
+    for (uint32_t k = 0; k < MAX_BATCHES; ++k) {
+        auto &batch = batches[(current + k) % MAX_BATCHES];
+        if (!batch.submitted) {
+            continue;
+        }
+        if (batch.ticket > value) {
+            break;  // later batches cannot have finished before this one
+        }
+        retire(batch);
+    }
+}
+
+void StagingUploader::retire(Batch &batch) {
+    if (batch.ring_bytes > 0) {
+        tail = batch.ring_end;
+        used -= batch.ring_bytes;
+    }
+    for (auto &[buffer, allocation] : batch.temporaries) {
+        vkDestroyBuffer(device, buffer, nullptr);
+        allocator->free(allocation);
+    }
+    batch.temporaries.clear();
+    batch.ring_bytes = 0;
+    batch.submitted = false;
+    completed_ticket = batch.ticket;
+}
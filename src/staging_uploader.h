@@ -0,0 +1,130 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_STAGING_UPLOADER_H
+#define VK_TUTORIAL_STAGING_UPLOADER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "gpu_profiler.h"
+#include "vulkan_allocator.h"
+
+// A piece of persistently mapped staging memory, write into `data` and then
+// hand it to one of the copy_* calls.
+typedef struct StagingSpan {
+    void *data{nullptr};
+    VkBuffer buffer{VK_NULL_HANDLE};
+    VkDeviceSize offset{0};
+    VkDeviceSize size{0};
+} StagingSpan;
+
+// How staged pixel data maps onto an image's mip chain.
+typedef struct ImageLevels {
+    uint32_t provided{1};  // levels in the data, largest first, packed
+    uint32_t total{1};     // mip levels of the image
+    uint32_t block_extent{1};  // texel block edge, 4 for BC formats
+    uint32_t block_bytes{4};   // bytes per texel block, RGBA8 by default
+    // TRANSFER_DST_OPTIMAL leaves the chain for a graphics queue to finish
+    VkImageLayout final_layout{VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+} ImageLevels;
+
+// Batches host -> device copies through one persistently mapped ring buffer.
+// Copies are recorded into the current batch and only submitted on flush(),
+// so many resources share a single vkQueueSubmit. Each batch is identified
+// by a monotonically increasing ticket, which is also the value the batch
+// signals on the uploader's timeline semaphore. Other submissions can wait
+// on (timeline_semaphore(), ticket) on the GPU instead of the host waiting.
+// Every public call is serialized, upload_* keep reserve + copy together so
+// no other thread can flush the ring space between them. The queue has to be
+// of the family that uses the resources: copies transition images straight
+// to shader read, without a queue family ownership transfer.
+class StagingUploader {
+   public:
+    static const VkDeviceSize DEFAULT_RING_SIZE = 64ull << 20;  // 64 MiB
+    static const uint32_t MAX_BATCHES = 4;
+
+    void init(VkDevice device, DeviceAllocator *allocator, VkQueue queue,
+              uint32_t queue_family,
+              VkDeviceSize ring_size = DEFAULT_RING_SIZE);
+    void destroy();
+
+    // reserve ring space, blocks only if the ring is full of in-flight data
+    StagingSpan reserve(VkDeviceSize size, VkDeviceSize alignment = 16);
+    void copy_to_buffer(StagingSpan const &span, VkBuffer dst,
+                        VkDeviceSize dst_offset);
+    // transitions all levels UNDEFINED -> levels.final_layout
+    void copy_to_image(StagingSpan const &span, VkImage dst, uint32_t width,
+                       uint32_t height, ImageLevels const &levels = {});
+    void upload_buffer(VkBuffer dst, VkDeviceSize dst_offset, void const *data,
+                       VkDeviceSize size);
+    void upload_image(VkImage dst, uint32_t width, uint32_t height,
+                      void const *data, VkDeviceSize size,
+                      ImageLevels const &levels = {});
+    // bytes of the first levels.provided levels
+    static VkDeviceSize image_size(uint32_t width, uint32_t height,
+                                   ImageLevels const &levels);
+
+    // submit everything recorded so far, returns its ticket (0 if empty)
+    uint64_t flush();
+    // ticket that will cover every copy recorded up to now
+    uint64_t pending_ticket() const;
+    bool is_complete(uint64_t ticket);
+    void wait(uint64_t ticket);
+    VkSemaphore timeline_semaphore() const { return timeline; }
+    uint32_t family() const { return queue_family; }
+    // time every batch on the upload queue, one profiler slot per batch
+    void set_profiler(GpuProfiler *profiler) { this->profiler = profiler; }
+
+   private:
+    typedef struct Batch {
+        VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+        uint64_t ticket{0};
+        VkDeviceSize ring_end{0};
+        VkDeviceSize ring_bytes{0};
+        bool recording{false};
+        bool submitted{false};
+        uint32_t zone{UINT32_MAX};
+        // oversized uploads that did not fit into the ring
+        std::vector<std::pair<VkBuffer, Allocation>> temporaries;
+    } Batch;
+
+    VkDevice device{VK_NULL_HANDLE};
+    // public calls nest (upload_* -> reserve -> flush), hence recursive
+    mutable std::recursive_mutex mutex;
+    DeviceAllocator *allocator{nullptr};
+    VkQueue queue{VK_NULL_HANDLE};
+    uint32_t queue_family{0};
+    VkCommandPool command_pool{VK_NULL_HANDLE};
+    VkSemaphore timeline{VK_NULL_HANDLE};
+    GpuProfiler *profiler{nullptr};
+    uint32_t staging_memory_type{0};
+
+    VkBuffer ring_buffer{VK_NULL_HANDLE};
+    Allocation ring_allocation;
+    VkDeviceSize ring_size{0};
+    VkDeviceSize head{0};
+    VkDeviceSize tail{0};
+    VkDeviceSize used{0};
+
+    std::vector<Batch> batches;
+    uint32_t current{0};  // batch slot being recorded
+    uint64_t next_ticket{1};
+    uint64_t completed_ticket{0};
+
+    VkCommandBuffer command_buffer();
+    bool try_reserve(VkDeviceSize size, VkDeviceSize alignment,
+                     VkDeviceSize &offset);
+    bool wait_oldest();
+    void wait_value(uint64_t value);
+    void retire(Batch &batch);
+    void poll();
+    void create_staging_buffer(VkDeviceSize size, VkBuffer &buffer,
+                               Allocation &allocation);
+};
+
+#endif  // VK_TUTORIAL_STAGING_UPLOADER_H
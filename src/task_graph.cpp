@@ -0,0 +1,156 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "task_graph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "cpu_trace.h"
+
+TaskGraph::Node TaskGraph::add(char const *name, std::function<void()> fn,
+                               std::vector<Node> const &dependencies,
+                               bool main_thread) {
+    auto node = (Node)steps.size();
+    for (auto dependency : dependencies) {
+        if (dependency >= node) {
+            throw std::runtime_error("task graph dependency added too late!");
+        }
+        steps[dependency].dependents.push_back(node);
+    }
+    steps.push_back(Step{.name = name,
+                         .fn = std::move(fn),
+                         .dependencies = dependencies,
+                         .dependents = {},
+                         .main_thread = main_thread,
+                         .pending = (uint32_t)dependencies.size()});
+    return node;
+}
+
+void TaskGraph::run(ThreadPool &pool) {
+    this->pool = &pool;
+    thread_count = pool.size() + 1;
+    start = std::chrono::steady_clock::now();
+
+    if (pool.size() == 0) {
+        // insertion order is a valid topological order
+        for (Node node = 0; node < steps.size(); ++node) {
+            execute(node, 0);
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    } else {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (Node node = 0; node < steps.size(); ++node) {
+            if (steps[node].pending == 0) {
+                dispatch(node);
+            }
+        }
+        while (true) {
+            step_finished.wait(
+                lock, [&]() { return !main_ready.empty() || in_flight == 0; });
+            if (!main_ready.empty() && !error) {
+                auto node = main_ready.front();
+                main_ready.pop_front();
+                ++in_flight;
+                lock.unlock();
+                execute(node, 0);
+                lock.lock();
+                continue;
+            }
+            if (in_flight == 0) {
+                break;
+            }
+            main_ready.clear();  // failed, drain the workers only
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    wall_ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+}
+
+// called with the mutex held
+void TaskGraph::dispatch(Node node) {
+    if (steps[node].main_thread) {
+        main_ready.push_back(node);
+        step_finished.notify_all();
+        return;
+    }
+    ++in_flight;
+    pool->submit([this, node](uint32_t worker) { execute(node, worker + 1); });
+}
+
+void TaskGraph::execute(Node node, uint32_t worker) {
+    auto &step = steps[node];
+    auto since_start = [&]() {
+        return std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+            .count();
+    };
+    step.worker = worker;
+    step.start_ms = since_start();
+    std::exception_ptr step_error;
+    try {
+        CPU_ZONE(step.name);
+        step.fn();
+    } catch (...) {
+        step_error = std::current_exception();
+    }
+    step.end_ms = since_start();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (step_error && !error) {
+        error = step_error;
+    }
+    if (!error) {
+        for (auto dependent : step.dependents) {
+            if (--steps[dependent].pending == 0 && pool->size() > 0) {
+                dispatch(dependent);
+            }
+        }
+    }
+    if (pool->size() > 0) {
+        --in_flight;
+        step_finished.notify_all();
+    }
+}
+
+void TaskGraph::print_summary(std::ostream &os) const {
+    double step_total_ms = 0.0;
+    // longest chain of step durations, steps are topologically ordered
+    std::vector<double> chain_ms(steps.size(), 0.0);
+    double critical_ms = 0.0;
+    for (Node node = 0; node < steps.size(); ++node) {
+        auto duration = steps[node].end_ms - steps[node].start_ms;
+        step_total_ms += duration;
+        double longest_dependency = 0.0;
+        for (auto dependency : steps[node].dependencies) {
+            longest_dependency =
+                std::max(longest_dependency, chain_ms[dependency]);
+        }
+        chain_ms[node] = longest_dependency + duration;
+        critical_ms = std::max(critical_ms, chain_ms[node]);
+    }
+    os << "init graph: " << steps.size() << " steps on " << thread_count
+       << " threads, wall " << wall_ms << " ms, steps total " << step_total_ms
+       << " ms, critical path " << critical_ms << " ms\n";
+}
+
+void TaskGraph::print_timeline(std::ostream &os) const {
+    std::vector<Node> order(steps.size());
+    for (Node node = 0; node < steps.size(); ++node) {
+        order[node] = node;
+    }
+    std::sort(order.begin(), order.end(), [&](Node a, Node b) {
+        return steps[a].start_ms < steps[b].start_ms;
+    });
+    for (auto node : order) {
+        auto const &step = steps[node];
+        os << "  [" << step.worker << "] " << step.start_ms << " - "
+           << step.end_ms << " ms " << step.name << '\n';
+    }
+}
@@ -0,0 +1,70 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_TASK_GRAPH_H
+#define VK_TUTORIAL_TASK_GRAPH_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "thread_pool.h"
+
+// One-shot dependency graph of named steps. A step is started as soon as
+// all of its dependencies finished; steps marked main_thread (window system
+// calls) run on the thread calling run(), everything else on the pool. An
+// empty pool runs the steps serially in insertion order. Each step records
+// its start/end time and shows up as a CPU trace zone.
+class TaskGraph {
+   public:
+    typedef uint32_t Node;
+
+    // dependencies must have been added before, which rules out cycles
+    Node add(char const *name, std::function<void()> fn,
+             std::vector<Node> const &dependencies = {},
+             bool main_thread = false);
+    // blocks until every step finished, rethrows the first exception (the
+    // steps depending on a failed one are skipped)
+    void run(ThreadPool &pool);
+
+    // wall time against summed step time and the critical path
+    void print_summary(std::ostream &os) const;
+    void print_timeline(std::ostream &os) const;
+
+   private:
+    typedef struct Step {
+        char const *name;
+        std::function<void()> fn;
+        std::vector<Node> dependencies;
+        std::vector<Node> dependents;
+        bool main_thread{false};
+        uint32_t pending{0};  // unfinished dependencies
+        uint32_t worker{0};   // 0 is the calling thread
+        double start_ms{0.0};
+        double end_ms{0.0};
+    } Step;
+
+    std::vector<Step> steps;
+    ThreadPool *pool{nullptr};
+    uint32_t thread_count{1};
+    double wall_ms{0.0};
+
+    std::mutex mutex;
+    std::condition_variable step_finished;
+    std::deque<Node> main_ready;
+    uint32_t in_flight{0};  // submitted to the pool, not finished yet
+    std::exception_ptr error;
+    std::chrono::steady_clock::time_point start;
+
+    void dispatch(Node node);
+    void execute(Node node, uint32_t worker);
+};
+
+#endif  // VK_TUTORIAL_TASK_GRAPH_H
@@ -0,0 +1,368 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "texture_streamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include "../external/stb_image.h"
+#include "cpu_trace.h"
+#include "ktx2.h"
+
+void TextureStreamer::init(VkPhysicalDevice physical_device, VkDevice device,
+                           DeviceAllocator *allocator,
+                           StagingUploader *uploader,
+                           CommandRecycler *graphics_commands,
+                           MipGeneration mip_generation,
+                           uint32_t decode_threads, uint32_t queue_capacity,
+                           VkDeviceSize upload_budget) {
+    this->physical_device = physical_device;
+    this->device = device;
+    this->allocator = allocator;
+    this->uploader = uploader;
+    this->graphics_commands = graphics_commands;
+    this->mip_generation = mip_generation;
+    // blitted chains are copied on the upload queue and finished on the
+    // graphics one without an ownership transfer, so both need one family
+    if (mip_generation == MIP_GENERATION_BLIT &&
+        uploader->family() != graphics_commands->family()) {
+        throw std::runtime_error(
+            "mip blits need uploads on the graphics queue family!");
+    }
+    this->queue_capacity = std::max(queue_capacity, 1u);
+    this->upload_budget = upload_budget;
+    stopping = false;
+    decoders.init(std::max(decode_threads, 1u));
+}
+
+void TextureStreamer::destroy() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    not_full.notify_all();
+    decoders.destroy();
+    for (auto &decoded : ready) {
+        release(decoded);
+    }
+    ready.clear();
+    for (auto &texture : textures) {
+        vkDestroyImageView(device, texture.view, nullptr);
+        vkDestroyImage(device, texture.image, nullptr);
+        allocator->free(texture.allocation);
+    }
+    textures.clear();
+    uploading.clear();
+    pending_blits.clear();
+}
+
+uint32_t TextureStreamer::request(std::string path, AssetPack const *pack) {
+    // packed textures are already in upload layout, nothing to decode and
+    // nothing owned, so they skip the bounded queue wait; texture() has
+    // checked the header, a corrupt one throws before anything is recorded
+    auto packed = pack ? pack->texture(path) : TextureView{};
+    auto id = (uint32_t)textures.size();
+    textures.push_back(Texture{.path = path});
+    ++counters.requested;
+
+    if (packed.levels) {
+        auto const &header = packed.header;
+        Decoded decoded{.id = id,
+                        .pixels =
+                            static_cast<unsigned char const *>(packed.levels),
+                        .width = header.width,
+                        .height = header.height,
+                        .mip_levels = header.mip_levels,
+                        .provided_levels = header.mip_levels,
+                        .format = (VkFormat)header.format,
+                        .block_extent = header.block_extent,
+                        .block_bytes = header.block_bytes};
+        if (upload_size(decoded) != packed.size ||
+            !supports_sampled_format(physical_device, decoded.format)) {
+            decoded.pixels = nullptr;  // reported as failed by update()
+        }
+        ++counters.packed;
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(std::move(decoded));
+        return id;
+    }
+
+    decoders.submit([this, id, path = std::move(path)](uint32_t) {
+        decode(id, path);
+    });
+    return id;
+}
+
+void TextureStreamer::decode(uint32_t id, std::string const &path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return;
+        }
+    }
+    Decoded decoded{.id = id};
+    auto decode_start = std::chrono::steady_clock::now();
+    if (is_ktx2_path(path)) {
+        load_compressed(decoded, path);
+    } else {
+        CPU_ZONE("decode texture");
+        int width = 0, height = 0, channels = 0;
+        decoded.pixels = stbi_load(path.c_str(), &width, &height, &channels,
+                                   STBI_rgb_alpha);
+        // a failed load stays 0 x 0, update() reports it and keeps the
+        // placeholder
+        if (decoded.pixels) {
+            decoded.stbi_owned = true;
+            decoded.width = (uint32_t)width;
+            decoded.height = (uint32_t)height;
+            decoded.mip_levels = mip_generation == MIP_GENERATION_NONE
+                                     ? 1
+                                     : mip_level_count(decoded.width,
+                                                       decoded.height);
+        }
+    }
+    if (decoded.pixels && decoded.chain.empty() &&
+        mip_generation == MIP_GENERATION_CPU) {
+        CPU_ZONE("build mip chain");
+        decoded.chain =
+            build_mip_chain_rgba8(decoded.pixels, decoded.width,
+                                  decoded.height, decoded.mip_levels, true);
+        release(decoded);
+        decoded.pixels = decoded.chain.data();
+        decoded.provided_levels = decoded.mip_levels;
+    }
+    auto elapsed_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - decode_start)
+                          .count();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    decode_ms += elapsed_ms;
+    if (ready.size() >= queue_capacity) {
+        ++producer_waits;
+        not_full.wait(lock, [&]() {
+            return stopping || ready.size() < queue_capacity;
+        });
+    }
+    if (stopping) {
+        release(decoded);
+        return;
+    }
+    ready.push_back(std::move(decoded));
+}
+
+void TextureStreamer::load_compressed(Decoded &decoded,
+                                      std::string const &path) {
+    CPU_ZONE("load ktx2");
+    decoded.pixels = nullptr;
+    try {
+        auto image = load_ktx2(path);
+        if (!supports_sampled_format(physical_device, image.format)) {
+            std::cerr << "texture format " << image.format
+                      << " is not supported by the device! " << path << '\n';
+            return;
+        }
+        decoded.width = image.width;
+        decoded.height = image.height;
+        decoded.mip_levels = image.mip_levels;
+        decoded.provided_levels = image.mip_levels;
+        decoded.format = image.format;
+        decoded.block_extent = image.block_extent;
+        decoded.block_bytes = image.block_bytes;
+        decoded.chain = std::move(image.data);
+        decoded.pixels = decoded.chain.data();
+    } catch (std::exception const &e) {
+        std::cerr << e.what() << '\n';
+    }
+}
+
+void TextureStreamer::release(Decoded &decoded) {
+    if (decoded.stbi_owned) {
+        stbi_image_free(const_cast<unsigned char *>(decoded.pixels));
+    }
+    decoded.stbi_owned = false;
+    decoded.pixels = nullptr;
+}
+
+VkDeviceSize TextureStreamer::upload_size(Decoded const &decoded) {
+    if (!decoded.pixels) {
+        return 0;  // failed, nothing gets staged
+    }
+    return StagingUploader::image_size(
+        decoded.width, decoded.height,
+        {.provided = decoded.provided_levels,
+         .total = decoded.mip_levels,
+         .block_extent = decoded.block_extent,
+         .block_bytes = decoded.block_bytes});
+}
+
+uint32_t TextureStreamer::update() {
+    CPU_ZONE_FUNCTION();
+    // publish uploads the transfer queue has finished
+    uint32_t became_resident = 0;
+    for (size_t i = 0; i < uploading.size();) {
+        auto &texture = textures[uploading[i]];
+        if (!uploader->is_complete(texture.ticket)) {
+            ++i;
+            continue;
+        }
+        texture.state = TEXTURE_RESIDENT;
+        ++counters.resident;
+        ++became_resident;
+        uploading[i] = uploading.back();
+        uploading.pop_back();
+    }
+
+    // take as many decoded images as the per frame budget allows, always at
+    // least one so huge images still make progress
+    std::vector<Decoded> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        VkDeviceSize bytes = 0;
+        while (!ready.empty()) {
+            auto size = upload_size(ready.front());
+            if (!batch.empty() && bytes + size > upload_budget) {
+                break;
+            }
+            bytes += size;
+            batch.push_back(std::move(ready.front()));
+            ready.pop_front();
+        }
+    }
+    if (batch.empty()) {
+        return became_resident;
+    }
+    not_full.notify_all();
+
+    for (auto &decoded : batch) {
+        upload(decoded);
+    }
+    auto ticket = uploader->flush();
+
+    // one graphics submission blits every new chain once the copies landed,
+    // the timeline wait orders it after the copies of the same family
+    if (!pending_blits.empty()) {
+        auto command_buffer = graphics_commands->begin();
+        for (auto id : pending_blits) {
+            auto const &texture = textures[id];
+            record_mip_blits(command_buffer, texture.image, texture.width,
+                             texture.height, texture.mip_levels);
+        }
+        graphics_commands->submit(command_buffer,
+                                  uploader->timeline_semaphore(), ticket,
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT);
+        pending_blits.clear();
+    }
+    return became_resident;
+}
+
+void TextureStreamer::upload(Decoded &decoded) {
+    auto &texture = textures[decoded.id];
+    if (!decoded.pixels) {
+        std::cerr << "failed to load texture! " << texture.path << '\n';
+        texture.state = TEXTURE_FAILED;
+        ++counters.failed;
+        return;
+    }
+
+    VkImageCreateInfo image_info{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = decoded.format,
+        .extent{.width = decoded.width, .height = decoded.height, .depth = 1},
+        .mipLevels = decoded.mip_levels,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                 VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED};
+    if (vkCreateImage(device, &image_info, nullptr, &texture.image) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to create streamed image!");
+    }
+    VkMemoryRequirements mem_requirements;
+    vkGetImageMemoryRequirements(device, texture.image, &mem_requirements);
+    texture.allocation = allocator->allocate(
+        mem_requirements,
+        allocator->find_memory_type(mem_requirements.memoryTypeBits,
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+        false);
+    vkBindImageMemory(device, texture.image, texture.allocation.memory,
+                      texture.allocation.offset);
+
+    bool blit = decoded.provided_levels < decoded.mip_levels;
+    ImageLevels levels{
+        .provided = decoded.provided_levels,
+        .total = decoded.mip_levels,
+        .block_extent = decoded.block_extent,
+        .block_bytes = decoded.block_bytes,
+        .final_layout = blit ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+                             : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    auto size =
+        StagingUploader::image_size(decoded.width, decoded.height, levels);
+    uploader->upload_image(texture.image, decoded.width, decoded.height,
+                           decoded.pixels, size, levels);
+    release(decoded);
+    decoded.chain.clear();
+    texture.ticket = uploader->pending_ticket();
+    texture.format = decoded.format;
+    texture.width = decoded.width;
+    texture.height = decoded.height;
+    texture.mip_levels = decoded.mip_levels;
+    counters.bytes_uploaded += size;
+    counters.compressed += decoded.block_extent > 1 ? 1 : 0;
+    if (blit) {
+        pending_blits.push_back(decoded.id);
+    }
+
+    VkImageViewCreateInfo view_info{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = texture.image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = decoded.format,
+        .subresourceRange{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                          .baseMipLevel = 0,
+                          .levelCount = decoded.mip_levels,
+                          .baseArrayLayer = 0,
+                          .layerCount = 1}};
+    if (vkCreateImageView(device, &view_info, nullptr, &texture.view) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to create streamed image view!");
+    }
+    texture.state = TEXTURE_UPLOADING;
+    uploading.push_back(decoded.id);
+}
+
+bool TextureStreamer::is_resident(uint32_t id) const {
+    return textures[id].state == TEXTURE_RESIDENT;
+}
+
+VkImageView TextureStreamer::view(uint32_t id) const {
+    return is_resident(id) ? textures[id].view : VK_NULL_HANDLE;
+}
+
+TextureStreamerStats TextureStreamer::stats() const {
+    auto result = counters;
+    std::lock_guard<std::mutex> lock(mutex);
+    result.producer_waits = producer_waits;
+    result.decode_ms = decode_ms;
+    return result;
+}
+
+void TextureStreamer::print_stats(std::ostream &os) const {
+    auto s = stats();
+    os << "texture streaming: " << s.resident << "/" << s.requested
+       << " resident, " << s.failed << " failed, " << s.compressed
+       << " block compressed, " << s.packed << " from pack, "
+       << s.bytes_uploaded / (1024.0 * 1024.0) << " MiB uploaded, "
+       << s.decode_ms << " ms decoding, " << s.producer_waits
+       << " decoder waits, mips "
+       << (mip_generation == MIP_GENERATION_BLIT  ? "blit"
+           : mip_generation == MIP_GENERATION_CPU ? "cpu"
+                                                  : "off")
+       << '\n';
+}
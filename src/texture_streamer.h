@@ -0,0 +1,145 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_TEXTURE_STREAMER_H
+#define VK_TUTORIAL_TEXTURE_STREAMER_H
+
+#include <vulkan/vulkan.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "asset_pack.h"
+#include "command_recycler.h"
+#include "image_util.h"
+#include "staging_uploader.h"
+#include "thread_pool.h"
+#include "vulkan_allocator.h"
+
+typedef struct TextureStreamerStats {
+    uint32_t requested{0};
+    uint32_t resident{0};
+    uint32_t failed{0};
+    uint32_t compressed{0};  // loaded from KTX2 without decoding
+    uint32_t packed{0};      // copied straight out of an asset pack
+    uint64_t bytes_uploaded{0};
+    uint64_t producer_waits{0};  // decoders blocked on a full ready queue
+    double decode_ms{0.0};       // summed over all decode threads
+} TextureStreamerStats;
+
+// Loads textures without blocking the frame loop. Decode threads turn files
+// into RGBA8 pixels and push them into a bounded ready queue (decoders block
+// while it is full, so decoded memory stays capped). update(), called once
+// per frame on the render thread, drains the queue within a byte budget into
+// the StagingUploader's batch and publishes textures whose upload ticket
+// completed. Until then view() returns VK_NULL_HANDLE and the caller keeps
+// its placeholder bound. Mip chains are either box filtered on the decode
+// threads or blitted on the graphics queue, which waits for the upload
+// ticket on the GPU. .ktx2 files skip decoding entirely: their block
+// compressed levels are uploaded as stored, formats the device cannot sample
+// fail and leave the placeholder in place. Textures found in an AssetPack
+// are queued from the mapped file directly, without touching the decoders.
+class TextureStreamer {
+   public:
+    static const uint32_t DEFAULT_QUEUE_CAPACITY = 8;
+    static const VkDeviceSize DEFAULT_UPLOAD_BUDGET = 16ull << 20;  // 16 MiB
+
+    void init(VkPhysicalDevice physical_device, VkDevice device,
+              DeviceAllocator *allocator,
+              StagingUploader *uploader, CommandRecycler *graphics_commands,
+              MipGeneration mip_generation, uint32_t decode_threads,
+              uint32_t queue_capacity = DEFAULT_QUEUE_CAPACITY,
+              VkDeviceSize upload_budget = DEFAULT_UPLOAD_BUDGET);
+    // the device must be idle
+    void destroy();
+
+    // starts decoding right away, returns the texture id. When pack holds a
+    // texture named path it is uploaded from the mapping instead, the pack
+    // must stay open until the texture is resident.
+    uint32_t request(std::string path, AssetPack const *pack = nullptr);
+    // returns how many textures became resident since the last call
+    uint32_t update();
+
+    bool is_resident(uint32_t id) const;
+    VkImageView view(uint32_t id) const;
+    // upload ticket a frame sampling the texture should wait on
+    uint64_t ticket(uint32_t id) const { return textures[id].ticket; }
+
+    TextureStreamerStats stats() const;
+    void print_stats(std::ostream &os) const;
+
+   private:
+    typedef enum TextureState {
+        TEXTURE_DECODING,
+        TEXTURE_UPLOADING,
+        TEXTURE_RESIDENT,
+        TEXTURE_FAILED,
+    } TextureState;
+
+    typedef struct Texture {
+        std::string path;
+        TextureState state{TEXTURE_DECODING};
+        VkImage image{VK_NULL_HANDLE};
+        Allocation allocation;
+        VkImageView view{VK_NULL_HANDLE};
+        VkFormat format{VK_FORMAT_R8G8B8A8_SRGB};
+        uint32_t width{0};
+        uint32_t height{0};
+        uint32_t mip_levels{1};
+        uint64_t ticket{0};
+    } Texture;
+
+    typedef struct Decoded {
+        uint32_t id;
+        // stbi owned, chain.data() or pack memory, null when loading failed
+        unsigned char const *pixels{nullptr};
+        bool stbi_owned{false};
+        uint32_t width{0};
+        uint32_t height{0};
+        uint32_t mip_levels{1};
+        uint32_t provided_levels{1};  // levels present in pixels
+        // MIP_GENERATION_CPU levels or the contents of a KTX2 file
+        std::vector<unsigned char> chain;
+        VkFormat format{VK_FORMAT_R8G8B8A8_SRGB};
+        uint32_t block_extent{1};
+        uint32_t block_bytes{4};
+    } Decoded;
+
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkDevice device{VK_NULL_HANDLE};
+    DeviceAllocator *allocator{nullptr};
+    StagingUploader *uploader{nullptr};
+    CommandRecycler *graphics_commands{nullptr};
+    MipGeneration mip_generation{MIP_GENERATION_NONE};
+    ThreadPool decoders;
+    VkDeviceSize upload_budget{DEFAULT_UPLOAD_BUDGET};
+
+    // only touched by the render thread
+    std::vector<Texture> textures;
+    std::vector<uint32_t> uploading;
+    std::vector<uint32_t> pending_blits;  // uploaded, mips not recorded yet
+    TextureStreamerStats counters;
+
+    // bounded ready queue shared with the decoders
+    mutable std::mutex mutex;
+    std::condition_variable not_full;
+    std::deque<Decoded> ready;
+    uint32_t queue_capacity{DEFAULT_QUEUE_CAPACITY};
+    bool stopping{false};
+    uint64_t producer_waits{0};
+    double decode_ms{0.0};
+
+    void decode(uint32_t id, std::string const &path);
+    void load_compressed(Decoded &decoded, std::string const &path);
+    static void release(Decoded &decoded);
+    static VkDeviceSize upload_size(Decoded const &decoded);
+    void upload(Decoded &decoded);
+};
+
+#endif  // VK_TUTORIAL_TEXTURE_STREAMER_H
@@ -0,0 +1,97 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "thread_pool.h"
+
+#include <atomic>
+#include <string>
+
+#include "cpu_trace.h"
+
+void ThreadPool::init(uint32_t thread_count) {
+    stopping = false;
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back(&ThreadPool::worker_main, this, i);
+    }
+}
+
+void ThreadPool::destroy() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_available.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+}
+
+void ThreadPool::submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    task_available.notify_one();
+}
+
+void ThreadPool::parallel_for(
+    uint32_t job_count,
+    std::function<void(uint32_t job, uint32_t worker)> fn) {
+    if (job_count == 0) {
+        return;
+    }
+    // no workers, run inline so callers never deadlock
+    if (threads.empty()) {
+        for (uint32_t job = 0; job < job_count; ++job) {
+            fn(job, 0);
+        }
+        return;
+    }
+
+    std::atomic<uint32_t> remaining{job_count};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    for (uint32_t job = 0; job < job_count; ++job) {
+        submit([&, job](uint32_t worker) {
+            try {
+                fn(job, worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            if (--remaining == 0) {
+                std::lock_guard<std::mutex> lock(mutex);
+                task_finished.notify_all();
+            }
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    task_finished.wait(lock, [&]() { return remaining == 0; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::worker_main(uint32_t worker) {
+    if (CpuTrace::is_enabled()) {
+        CpuTrace::set_thread_name("worker " + std::to_string(worker));
+    }
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_available.wait(lock,
+                                [&]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;  // stopping and drained
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task(worker);
+    }
+}
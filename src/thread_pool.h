@@ -0,0 +1,47 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_THREAD_POOL_H
+#define VK_TUTORIAL_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling tasks from one shared queue. Tasks get
+// the index of the worker running them, so callers can keep per-worker state
+// (command pools, scratch memory) without locking.
+class ThreadPool {
+   public:
+    typedef std::function<void(uint32_t worker)> Task;
+
+    void init(uint32_t thread_count);
+    void destroy();
+    ~ThreadPool() { destroy(); }
+
+    uint32_t size() const { return (uint32_t)threads.size(); }
+
+    void submit(Task task);
+    // run fn(job, worker) for job in [0, job_count) and block until all of
+    // them finished, rethrows the first exception a job raised
+    void parallel_for(uint32_t job_count,
+                      std::function<void(uint32_t job, uint32_t worker)> fn);
+
+   private:
+    std::vector<std::thread> threads;
+    std::deque<Task> tasks;
+    std::mutex mutex;
+    std::condition_variable task_available;
+    std::condition_variable task_finished;
+    bool stopping{false};
+
+    void worker_main(uint32_t worker);
+};
+
+#endif  // VK_TUTORIAL_THREAD_POOL_H
@@ -0,0 +1,91 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_VERTEX_H
+#define VK_TUTORIAL_VERTEX_H
+
+#include <vulkan/vulkan.h>
+
+#include <Eigen/Core>
+#include <array>
+#include <cstddef>
+
+typedef struct Vertex {
+    using Vec2f = Eigen::Vector2f;
+    using Vec3f = Eigen::Vector3f;
+    Vec3f pos;
+    Vec3f color;
+    Vec2f tex_coord;
+
+    // A vertex binding describes at which rate to load data from memory
+    // throughout the vertices.
+    static VkVertexInputBindingDescription get_binding_description() {
+        VkVertexInputBindingDescription binding_description{
+            .binding = 0,
+            .stride = sizeof(Vertex),
+            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX};
+        return binding_description;
+    }
+
+    static auto get_attribute_descriptions() {
+        std::array<VkVertexInputAttributeDescription, 3>
+            attribute_descriptions = {
+                VkVertexInputAttributeDescription{
+                    .location = 0,  // location in vertex shader input
+                    .binding = 0,
+                    .format = VK_FORMAT_R32G32B32_SFLOAT,  // vec3
+                    .offset =
+                        (uint32_t)offsetof(Vertex, pos)  // wtf, it exists?
+                },
+                VkVertexInputAttributeDescription{
+                    .location = 1,
+                    .binding = 0,
+                    .format = VK_FORMAT_R32G32B32_SFLOAT,  // vec3
+                    .offset = (uint32_t)offsetof(Vertex, color)},
+                VkVertexInputAttributeDescription{
+                    .location = 2,
+                    .binding = 0,
+                    .format = VK_FORMAT_R32G32_SFLOAT,  // vec2
+                    .offset = (uint32_t)offsetof(Vertex, tex_coord)}};
+
+        return attribute_descriptions;
+    }
+
+} Vertex;
+
+// Per-instance attributes, fed from binding 1 and advanced once per instance.
+typedef struct InstanceData {
+    Eigen::Matrix4f model;  // column major, one vec4 attribute per column
+    Eigen::Vector4f tint;
+
+    static VkVertexInputBindingDescription get_binding_description() {
+        VkVertexInputBindingDescription binding_description{
+            .binding = 1,
+            .stride = sizeof(InstanceData),
+            .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE};
+        return binding_description;
+    }
+
+    // a mat4 input takes four consecutive locations, 3..6, tint is 7
+    static auto get_attribute_descriptions() {
+        std::array<VkVertexInputAttributeDescription, 5>
+            attribute_descriptions{};
+        for (uint32_t column = 0; column < 4; ++column) {
+            attribute_descriptions[column] = {
+                .location = 3 + column,
+                .binding = 1,
+                .format = VK_FORMAT_R32G32B32A32_SFLOAT,  // vec4
+                .offset = (uint32_t)(offsetof(InstanceData, model) +
+                                     column * sizeof(Eigen::Vector4f))};
+        }
+        attribute_descriptions[4] = {
+            .location = 7,
+            .binding = 1,
+            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+            .offset = (uint32_t)offsetof(InstanceData, tint)};
+        return attribute_descriptions;
+    }
+} InstanceData;
+
+#endif  // VK_TUTORIAL_VERTEX_H
@@ -0,0 +1,280 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "vulkan_allocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+    if (alignment <= 1) {
+        return value;
+    }
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void DeviceAllocator::init(VkPhysicalDevice physical_device, VkDevice device,
+                           VkDeviceSize preferred_block_size) {
+    this->device = device;
+    this->preferred_block_size = preferred_block_size;
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    buffer_image_granularity = properties.limits.bufferImageGranularity;
+    max_allocation_count = properties.limits.maxMemoryAllocationCount;
+
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+    pools.resize(memory_properties.memoryTypeCount * 2);
+    for (uint32_t i = 0; i < pools.size(); ++i) {
+        pools[i].memory_type = i / 2;
+    }
+}
+
+void DeviceAllocator::destroy() {
+    for (auto &pool : pools) {
+        for (auto &block : pool.blocks) {
+            release_block(block);
+        }
+        pool.blocks.clear();
+    }
+    pools.clear();
+}
+
+uint32_t DeviceAllocator::find_memory_type(
+    uint32_t type_filter, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+        if (((type_filter >> i) & 1) &&
+            (memory_properties.memoryTypes[i].propertyFlags & properties) ==
+                properties) {
+            return i;
+        }
+    }
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+VkDeviceSize DeviceAllocator::block_size_for(uint32_t memory_type) const {
+    auto heap_index = memory_properties.memoryTypes[memory_type].heapIndex;
+    auto heap_size = memory_properties.memoryHeaps[heap_index].size;
+    // small heaps (e.g. 256 MiB BAR windows) should not be eaten by one slab
+    if (heap_size <= (1ull << 30)) {
+        return std::min(preferred_block_size, heap_size / 8);
+    }
+    return preferred_block_size;
+}
+
+uint32_t DeviceAllocator::create_block(Pool &pool, VkDeviceSize size,
+                                       bool dedicated) {
+    if (max_allocation_count != 0 &&
+        device_allocation_count >= max_allocation_count) {
+        throw std::runtime_error("exceeded maxMemoryAllocationCount!");
+    }
+
+    VkMemoryAllocateInfo alloc_info{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = size,
+        .memoryTypeIndex = pool.memory_type};
+
+    Block block{.size = size, .dedicated = dedicated};
+    if (vkAllocateMemory(device, &alloc_info, nullptr, &block.memory) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate device memory block!");
+    }
+    ++device_allocation_count;
+
+    // host visible blocks are mapped once and stay mapped until released
+    if (memory_properties.memoryTypes[pool.memory_type].propertyFlags &
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, block.memory, 0, VK_WHOLE_SIZE, 0,
+                        &block.mapped) != VK_SUCCESS) {
+            throw std::runtime_error("failed to map device memory block!");
+        }
+    }
+    block.free_ranges.push_back({0, size});
+
+    // reuse a released slot so outstanding block indices stay valid
+    for (uint32_t i = 0; i < pool.blocks.size(); ++i) {
+        if (pool.blocks[i].memory == VK_NULL_HANDLE) {
+            pool.blocks[i] = std::move(block);
+            return i;
+        }
+    }
+    pool.blocks.push_back(std::move(block));
+    return (uint32_t)pool.blocks.size() - 1;
+}
+
+void DeviceAllocator::release_block(Block &block) {
+    if (block.memory == VK_NULL_HANDLE) {
+        return;
+    }
+    if (block.mapped) {
+        vkUnmapMemory(device, block.memory);
+    }
+    vkFreeMemory(device, block.memory, nullptr);
+    --device_allocation_count;
+    block = Block{};
+}
+
+bool DeviceAllocator::sub_allocate(Block &block, VkDeviceSize size,
+                                   VkDeviceSize alignment,
+                                   VkDeviceSize &offset) {
+    auto &ranges = block.free_ranges;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        auto range = ranges[i];
+        auto aligned = align_up(range.offset, alignment);
+        auto padding = aligned - range.offset;
+        if (padding + size > range.size) {
+            continue;
+        }
+        // split [range] into [padding][allocation][tail]
+        auto tail = range.size - padding - size;
+        ranges.erase(ranges.begin() + i);
+        if (tail > 0) {
+            ranges.insert(ranges.begin() + i, {aligned + size, tail});
+        }
+        if (padding > 0) {
+            ranges.insert(ranges.begin() + i, {range.offset, padding});
+        }
+        block.used += size;
+        ++block.allocation_count;
+        offset = aligned;
+        return true;
+    }
+    return false;
+}
+
+Allocation DeviceAllocator::allocate(VkMemoryRequirements const &requirements,
+                                     uint32_t memory_type, bool linear) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // only split linear/optimal resources when the device actually needs it
+    bool separate = buffer_image_granularity > 1 && !linear;
+    uint32_t pool_index = memory_type * 2 + (separate ? 1 : 0);
+    auto &pool = pools[pool_index];
+
+    Allocation allocation{.size = requirements.size, .pool = pool_index};
+    auto block_size = block_size_for(memory_type);
+
+    // big resources get their own VkDeviceMemory, slabs would only waste it
+    if (requirements.size > block_size / 2) {
+        allocation.block = create_block(pool, requirements.size, true);
+        auto &block = pool.blocks[allocation.block];
+        block.free_ranges.clear();
+        block.used = requirements.size;
+        block.allocation_count = 1;
+        allocation.memory = block.memory;
+        allocation.mapped = block.mapped;
+        return allocation;
+    }
+
+    VkDeviceSize offset = 0;
+    uint32_t block_index = UINT32_MAX;
+    for (uint32_t i = 0; i < pool.blocks.size(); ++i) {
+        auto &block = pool.blocks[i];
+        if (block.memory == VK_NULL_HANDLE || block.dedicated ||
+            block.size - block.used < requirements.size) {
+            continue;
+        }
+        if (sub_allocate(block, requirements.size, requirements.alignment,
+                         offset)) {
+            block_index = i;
+            break;
+        }
+    }
+    if (block_index == UINT32_MAX) {
+        block_index = create_block(pool, block_size, false);
+        if (!sub_allocate(pool.blocks[block_index], requirements.size,
+                          requirements.alignment, offset)) {
+            throw std::runtime_error("failed to sub-allocate device memory!");
+        }
+    }
+
+    auto &block = pool.blocks[block_index];
+    allocation.memory = block.memory;
+    allocation.offset = offset;
+    allocation.block = block_index;
+    if (block.mapped) {
+        allocation.mapped = static_cast<char *>(block.mapped) + offset;
+    }
+    return allocation;
+}
+
+void DeviceAllocator::free(Allocation &allocation) {
+    if (allocation.memory == VK_NULL_HANDLE) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &pool = pools[allocation.pool];
+    auto &block = pool.blocks[allocation.block];
+
+    if (block.dedicated) {
+        release_block(block);
+        allocation = Allocation{};
+        return;
+    }
+
+    // return the range to the free list, merging with adjacent neighbours
+    auto &ranges = block.free_ranges;
+    auto it = std::lower_bound(
+        ranges.begin(), ranges.end(), allocation.offset,
+        [](FreeRange const &r, VkDeviceSize off) { return r.offset < off; });
+    it = ranges.insert(it, {allocation.offset, allocation.size});
+    if (it + 1 != ranges.end() && it->offset + it->size == (it + 1)->offset) {
+        it->size += (it + 1)->size;
+        ranges.erase(it + 1);
+    }
+    if (it != ranges.begin() &&
+        (it - 1)->offset + (it - 1)->size == it->offset) {
+        (it - 1)->size += it->size;
+        ranges.erase(it);
+    }
+    block.used -= allocation.size;
+    --block.allocation_count;
+
+    // keep one empty slab per pool around to avoid alloc/free ping-pong
+    if (block.allocation_count == 0) {
+        auto empty_blocks = std::count_if(
+            pool.blocks.begin(), pool.blocks.end(), [](Block const &b) {
+                return b.memory != VK_NULL_HANDLE && !b.dedicated &&
+                       b.allocation_count == 0;
+            });
+        if (empty_blocks > 1) {
+            release_block(block);
+        }
+    }
+    allocation = Allocation{};
+}
+
+AllocatorStats DeviceAllocator::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    AllocatorStats result;
+    VkDeviceSize total_free = 0, largest_free = 0;
+    for (auto const &pool : pools) {
+        for (auto const &block : pool.blocks) {
+            if (block.memory == VK_NULL_HANDLE) {
+                continue;
+            }
+            result.bytes_reserved += block.size;
+            result.bytes_used += block.used;
+            result.block_count += 1;
+            result.dedicated_count += block.dedicated ? 1 : 0;
+            result.live_allocations += block.allocation_count;
+            for (auto const &range : block.free_ranges) {
+                total_free += range.size;
+                largest_free = std::max(largest_free, range.size);
+            }
+        }
+    }
+    if (total_free > 0) {
+        result.fragmentation = 1.0f - (float)largest_free / (float)total_free;
+    }
+    return result;
+}
+
+void DeviceAllocator::print_stats(std::ostream &os) const {
+    auto s = stats();
+    auto to_mib = [](VkDeviceSize bytes) { return bytes / (1024.0 * 1024.0); };
+    os << "device memory: " << s.block_count << " blocks ("
+       << s.dedicated_count << " dedicated), " << to_mib(s.bytes_reserved)
+       << " MiB reserved, " << to_mib(s.bytes_used) << " MiB used, "
+       << s.live_allocations << " live allocations, fragmentation "
+       << s.fragmentation * 100.0f << "%\n";
+}
@@ -0,0 +1,97 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_VULKAN_ALLOCATOR_H
+#define VK_TUTORIAL_VULKAN_ALLOCATOR_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// A sub-range of a VkDeviceMemory block handed out by DeviceAllocator.
+typedef struct Allocation {
+    VkDeviceMemory memory{VK_NULL_HANDLE};
+    VkDeviceSize offset{0};
+    VkDeviceSize size{0};
+    // non-null when the owning block is host visible (persistently mapped)
+    void *mapped{nullptr};
+    uint32_t pool{UINT32_MAX};
+    uint32_t block{UINT32_MAX};
+} Allocation;
+
+typedef struct AllocatorStats {
+    VkDeviceSize bytes_reserved{0};  // sum of all VkDeviceMemory blocks
+    VkDeviceSize bytes_used{0};      // sum of live sub-allocations
+    uint32_t block_count{0};         // live vkAllocateMemory calls
+    uint32_t dedicated_count{0};     // blocks holding a single big resource
+    uint32_t live_allocations{0};
+    // 1 - largest_free_range / total_free, 0 means free space is contiguous
+    float fragmentation{0.0f};
+} AllocatorStats;
+
+// Block based device memory sub-allocator. Every memory type gets its own
+// pool of large VkDeviceMemory slabs, resources are placed with a first-fit
+// free list honoring the requested alignment. When the device reports a
+// bufferImageGranularity > 1, linear (buffers) and optimal (images)
+// resources live in separate pools so they can never share a page.
+// allocate/free/stats may be called from several threads.
+class DeviceAllocator {
+   public:
+    static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull << 20;  // 64 MiB
+
+    void init(VkPhysicalDevice physical_device, VkDevice device,
+              VkDeviceSize preferred_block_size = DEFAULT_BLOCK_SIZE);
+    void destroy();
+
+    uint32_t find_memory_type(uint32_t type_filter,
+                              VkMemoryPropertyFlags properties) const;
+    Allocation allocate(VkMemoryRequirements const &requirements,
+                        uint32_t memory_type, bool linear);
+    void free(Allocation &allocation);
+
+    AllocatorStats stats() const;
+    void print_stats(std::ostream &os) const;
+
+   private:
+    typedef struct FreeRange {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    } FreeRange;
+
+    typedef struct Block {
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        VkDeviceSize size{0};
+        VkDeviceSize used{0};
+        void *mapped{nullptr};
+        uint32_t allocation_count{0};
+        bool dedicated{false};
+        std::vector<FreeRange> free_ranges;  // sorted by offset
+    } Block;
+
+    typedef struct Pool {
+        uint32_t memory_type{0};
+        std::vector<Block> blocks;
+    } Pool;
+
+    VkDevice device{VK_NULL_HANDLE};
+    mutable std::mutex mutex;  // guards pools and the counters below
+    VkPhysicalDeviceMemoryProperties memory_properties{};
+    VkDeviceSize buffer_image_granularity{1};
+    VkDeviceSize preferred_block_size{DEFAULT_BLOCK_SIZE};
+    uint32_t max_allocation_count{0};
+    uint32_t device_allocation_count{0};
+    // indexed by memory_type * 2 + (linear ? 0 : 1)
+    std::vector<Pool> pools;
+
+    VkDeviceSize block_size_for(uint32_t memory_type) const;
+    uint32_t create_block(Pool &pool, VkDeviceSize size, bool dedicated);
+    void release_block(Block &block);
+    static bool sub_allocate(Block &block, VkDeviceSize size,
+                             VkDeviceSize alignment, VkDeviceSize &offset);
+};
+
+#endif  // VK_TUTORIAL_VULKAN_ALLOCATOR_H
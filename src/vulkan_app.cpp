@@ -3,7 +3,11 @@
 //
 #include "vulkan_app.h"
 
+#include "cpu_trace.h"
 #include "eigen_helper.hpp"
+#include "image_util.h"
+#include "ktx2.h"
+#include "task_graph.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <SDL2/SDL_vulkan.h>
@@ -11,16 +15,30 @@
 
 #include <algorithm>  // Necessary for std::clamp
 #include <chrono>
+#include <cmath>
 #include <cstdint>  // Necessary for uint32_t
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <limits>  // Necessary for std::numeric_limits
+#include <numeric>
 #include <optional>
 #include <set>
+#include <thread>
 #include <vector>
 
 #include "../external/stb_image.h"
 
+VulkanApplication::VulkanApplication(AppOptions const &options) {
+    if (options.frames_in_flight < 1 ||
+        options.frames_in_flight > MAX_FRAMES_IN_FLIGHT) {
+        throw std::runtime_error("frames in flight must be within [1, " +
+                                 std::to_string(MAX_FRAMES_IN_FLIGHT) + "]!");
+    }
+    frames_in_flight = options.frames_in_flight;
+    this->options = options;
+}
+
 void VulkanApplication::run() {
     init_window();
     init_vulkan();
@@ -78,6 +96,7 @@ static void PopulateDebugMessengerCreateInfo(
 
 // shader code read helper
 static std::vector<char> read_file(std::string const &filename) {
+    CPU_ZONE_FUNCTION();
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
     if (!file.is_open()) {
         throw std::runtime_error("failed to open file! " + filename);
@@ -103,6 +122,9 @@ bool VulkanApplication::check_device_extension_support(
 
     std::set<std::string> required_extensions(device_extensions.begin(),
                                               device_extensions.end());
+    if (options.headless) {
+        required_extensions.clear();
+    }
     for (const auto &extension : available_extensions) {
         required_extensions.erase(extension.extensionName);
     }
@@ -168,7 +190,14 @@ bool VulkanApplication::check_extensions_support() {
         std::cout << '\t' << extension.extensionName << '\n';
     }
 
-    init_SDL2_extensions();
+    if (options.headless) {
+        // no window, so no surface extensions
+        if (enable_validation_layers) {
+            extension_names.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+    } else {
+        init_SDL2_extensions();
+    }
 
 #ifdef __APPLE__
     extension_names.emplace_back(
@@ -193,6 +222,9 @@ bool VulkanApplication::check_extensions_support() {
 }
 
 void VulkanApplication::init_window() {
+    if (options.headless) {
+        return;
+    }
     SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS);
     auto window_flags =
         SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_VULKAN;
@@ -207,6 +239,7 @@ void VulkanApplication::init_window() {
 }
 
 void VulkanApplication::setup_debug_messenger() {
+    CPU_ZONE_FUNCTION();
     if (!enable_validation_layers) {
         return;
     }
@@ -240,18 +273,20 @@ QueueFamilyIndices VulkanApplication::find_queue_families(
         physical_device, &queue_family_count, queue_families.data());
 
     for (uint32_t i = 0; i < queue_family_count; ++i) {
+        // uploads stay in the graphics family: exclusive images and buffers
+        // need no ownership transfer and the upload barriers may name
+        // graphics stages, see create_logical_device for the queue itself
         if (queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
             result.graphics_family = i;
-            // continue;
-        }
-
-        if (queue_families[i].queueFlags & VK_QUEUE_TRANSFER_BIT) {
             result.transfer_family = i;
         }
 
-        VkBool32 present_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface,
-                                             &present_support);
+        // nothing is ever presented headless, any family will do
+        VkBool32 present_support = options.headless;
+        if (!options.headless) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface,
+                                                 &present_support);
+        }
         if (present_support) {
             result.present_family = i;
         }
@@ -269,19 +304,48 @@ bool VulkanApplication::is_suitable_device(VkPhysicalDevice device) {
     bool swapchain_adequate = false;
 
     VkPhysicalDeviceFeatures features{};
-    vkGetPhysicalDeviceFeatures(physical_device, &features);
+    vkGetPhysicalDeviceFeatures(device, &features);
 
-    if (extensions_supported) {
+    // frame pacing and uploads are built on timeline semaphores (1.2 core)
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(device, &properties);
+    VkPhysicalDeviceVulkan12Features vulkan12_features{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    VkPhysicalDeviceFeatures2 features2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan12_features};
+    bool timeline_supported = false;
+    if (properties.apiVersion >= VK_API_VERSION_1_2) {
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+        timeline_supported = vulkan12_features.timelineSemaphore;
+    }
+
+    if (options.headless) {
+        swapchain_adequate = true;
+    } else if (extensions_supported) {
         auto swapchain_support = query_swapchain_support(device);
         swapchain_adequate = !swapchain_support.formats.empty() &&
                              !swapchain_support.present_modes.empty();
     }
 
+    // a pre-compressed texture is only worth it if it can be sampled as is
+    bool texture_supported = true;
+    if (is_ktx2_path(options.texture_path)) {
+        try {
+            texture_supported = supports_sampled_format(
+                device, peek_ktx2_format(options.texture_path));
+        } catch (std::exception const &) {
+            // missing files are reported by the streamer
+        }
+    }
+
     return indices.is_complete() && extensions_supported &&
-           swapchain_adequate && features.samplerAnisotropy;
+           swapchain_adequate && features.samplerAnisotropy &&
+           timeline_supported && texture_supported;
 }
 
 void VulkanApplication::pick_physical_device() {
+    CPU_ZONE_FUNCTION();
     vkEnumeratePhysicalDevices(instance, &device_count, nullptr);
     if (device_count == 0) {
         throw std::runtime_error("failed to find GPUs with Vulkan support!");
@@ -289,14 +353,19 @@ void VulkanApplication::pick_physical_device() {
 
     std::vector<VkPhysicalDevice> devices(device_count);
     vkEnumeratePhysicalDevices(instance, &device_count, devices.data());
-    physical_device = devices[0];  // select gpu:0 default
-
+    for (auto device : devices) {
+        if (is_suitable_device(device)) {
+            physical_device = device;
+            break;
+        }
+    }
     if (physical_device == VK_NULL_HANDLE) {
         throw std::runtime_error("failed to find a suitable GPU!");
     }
 }
 
 void VulkanApplication::create_logical_device() {
+    CPU_ZONE_FUNCTION();
     QueueFamilyIndices indices = find_queue_families(physical_device);
 
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
@@ -308,19 +377,64 @@ void VulkanApplication::create_logical_device() {
     //  std::cerr << "unique queue family size " << queue_families_set.size()
     //            << std::endl;
 
-    float queue_priority = 1.0f;
+    // a second graphics queue lets uploads overlap with the frames
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count,
+                                             nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count,
+                                             families.data());
+    auto graphics_queue_count = std::min(
+        families[indices.graphics_family.value()].queueCount, 2u);
+
+    float queue_priorities[] = {1.0f, 1.0f};
     for (auto queue_family : queue_families_set) {
         VkDeviceQueueCreateInfo queue_create_info{
-            .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
             .queueFamilyIndex = queue_family,
-            .queueCount = 1,
-            .pQueuePriorities = &queue_priority};
+            .queueCount = queue_family == indices.graphics_family.value()
+                              ? graphics_queue_count
+                              : 1u,
+            .pQueuePriorities = queue_priorities};
         queue_create_infos.push_back(queue_create_info);
     }
 
-    VkPhysicalDeviceFeatures device_features{.samplerAnisotropy = VK_TRUE};
+    // block compressed formats are only usable with their feature enabled
+    VkPhysicalDeviceFeatures supported_features{};
+    vkGetPhysicalDeviceFeatures(physical_device, &supported_features);
+    // indirect draws fall back to one command per call without these
+    multi_draw_indirect = supported_features.multiDrawIndirect;
+    draw_indirect_first_instance =
+        supported_features.drawIndirectFirstInstance;
+    VkPhysicalDeviceFeatures device_features{
+        .multiDrawIndirect = supported_features.multiDrawIndirect,
+        .drawIndirectFirstInstance =
+            supported_features.drawIndirectFirstInstance,
+        .samplerAnisotropy = VK_TRUE,
+        .textureCompressionASTC_LDR =
+            supported_features.textureCompressionASTC_LDR,
+        .textureCompressionBC = supported_features.textureCompressionBC};
+    VkPhysicalDeviceVulkan12Features vulkan12_features{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    VkPhysicalDeviceFeatures2 features2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan12_features};
+    vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+    // gpu profiling is optional, everything else must be there
+    host_query_reset = vulkan12_features.hostQueryReset;
+    draw_indirect_count = vulkan12_features.drawIndirectCount;
+    vulkan12_features = VkPhysicalDeviceVulkan12Features{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    vulkan12_features.drawIndirectCount = draw_indirect_count;
+    vulkan12_features.hostQueryReset = host_query_reset;
+    vulkan12_features.timelineSemaphore = VK_TRUE;
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    max_draw_indirect_count =
+        multi_draw_indirect ? properties.limits.maxDrawIndirectCount : 1;
     VkDeviceCreateInfo create_info{
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = &vulkan12_features,
         .queueCreateInfoCount =
             static_cast<uint32_t>(queue_create_infos.size()),
         .pQueueCreateInfos = queue_create_infos.data(),  // array here
@@ -336,6 +450,12 @@ void VulkanApplication::create_logical_device() {
         create_info.enabledLayerCount = 0;
     }
 
+    if (options.headless) {
+        // no VK_KHR_swapchain needed (or available on some software ICDs)
+        create_info.enabledExtensionCount = 0;
+        create_info.ppEnabledExtensionNames = nullptr;
+    }
+
     if (vkCreateDevice(physical_device, &create_info, nullptr, &device) !=
         VK_SUCCESS) {
         throw std::runtime_error("failed to create logical device!");
@@ -344,13 +464,20 @@ void VulkanApplication::create_logical_device() {
     // retrieving queue handles, zero means first queue(element 0)
     vkGetDeviceQueue(device, indices.graphics_family.value(), 0,
                      &graphics_queue);
-    vkGetDeviceQueue(device, indices.transfer_family.value(), 0,
-                     &transfer_queue);
+    vkGetDeviceQueue(device, indices.transfer_family.value(),
+                     graphics_queue_count - 1, &transfer_queue);
     vkGetDeviceQueue(device, indices.present_family.value(), 0, &present_queue);
+
+    allocator.init(physical_device, device);
+    pipeline_cache.init(physical_device, device);
 }
 
 // platform related part
 void VulkanApplication::create_surface() {
+    CPU_ZONE_FUNCTION();
+    if (options.headless) {
+        return;
+    }
     if (!SDL_Vulkan_CreateSurface(window, instance, &surface)) {
         throw std::runtime_error(
             "failed to create Vulkan compatible surface using SDL\n");
@@ -430,7 +557,8 @@ VkExtent2D VulkanApplication::choose_swap_extent(
     }
 }
 
-void VulkanApplication::create_swapchain() {
+bool VulkanApplication::create_swapchain(VkSwapchainKHR old_swapchain) {
+    CPU_ZONE_FUNCTION();
     SwapChainSupportDetails swapchain_support =
         query_swapchain_support(physical_device);
 
@@ -440,8 +568,9 @@ void VulkanApplication::create_swapchain() {
         choose_swap_present_mode(swapchain_support.present_modes);
     VkExtent2D extent = choose_swap_extent(swapchain_support.capabilities);
 
-    while (extent.width == 0 || extent.height == 0) {
-        return;
+    // minimized window, keep whatever swapchain we have
+    if (extent.width == 0 || extent.height == 0) {
+        return false;
     }
 
     // how many images in swap chain
@@ -467,8 +596,9 @@ void VulkanApplication::create_swapchain() {
         .preTransform = swapchain_support.capabilities.currentTransform,
         .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
         .presentMode = present_mode,
-        .clipped = VK_TRUE  // clip screen (window) obscured
-    };
+        .clipped = VK_TRUE,  // clip screen (window) obscured
+        // lets the driver hand over images instead of starting from scratch
+        .oldSwapchain = old_swapchain};
 
     auto indices = find_queue_families(physical_device);
     uint32_t queue_family_indices[] = {indices.graphics_family.value(),
@@ -499,9 +629,29 @@ void VulkanApplication::create_swapchain() {
 
     swapchain_image_format = surface_format.format;
     swapchain_extent = extent;
+    return true;
+}
+
+// stands in for the swapchain when headless: one color target per frame
+// slot, left in TRANSFER_SRC_OPTIMAL so it can be read back
+void VulkanApplication::create_offscreen_targets() {
+    CPU_ZONE_FUNCTION();
+    swapchain_image_format = VK_FORMAT_R8G8B8A8_UNORM;
+    swapchain_extent = {(uint32_t)width, (uint32_t)height};
+    swapchain_images.resize(frames_in_flight);
+    offscreen_allocations.resize(frames_in_flight);
+    for (uint32_t i = 0; i < frames_in_flight; ++i) {
+        create_image(width, height, 1, swapchain_image_format,
+                     VK_IMAGE_TILING_OPTIMAL,
+                     VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                         VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapchain_images[i],
+                     offscreen_allocations[i]);
+    }
 }
 
 void VulkanApplication::create_image_views() {
+    CPU_ZONE_FUNCTION();
     swapchain_image_views.resize(swapchain_images.size());
     for (size_t i = 0; i < swapchain_images.size(); ++i) {
         swapchain_image_views[i] =
@@ -510,6 +660,7 @@ void VulkanApplication::create_image_views() {
 }
 
 void VulkanApplication::create_render_pass() {
+    CPU_ZONE_FUNCTION();
     VkAttachmentDescription color_attachment{
         .format = swapchain_image_format,
         .samples = VK_SAMPLE_COUNT_1_BIT,
@@ -518,9 +669,10 @@ void VulkanApplication::create_render_pass() {
             VK_ATTACHMENT_STORE_OP_STORE,  // after rendering, stored in mem.
         .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,  // not use
         .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,     // pixel format
-        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR  // directly present
-                                                        // using the swapchain
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,  // pixel format
+        // directly present using the swapchain, or read back when headless
+        .finalLayout = options.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                                        : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
     };  // define single color buffer attachment (one of the images from
         // swapchain)
 
@@ -559,12 +711,12 @@ void VulkanApplication::create_render_pass() {
 }
 
 VkShaderModule VulkanApplication::create_shader_module(
-    std::vector<char> const &code) {
+    AssetView const &code) {
     VkShaderModuleCreateInfo create_info{
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .codeSize = code.size(),
+        .codeSize = code.size,
         .pCode = reinterpret_cast<const uint32_t *>(
-            code.data())  // need reinterpret (convert raw data)
+            code.data)  // need reinterpret (convert raw data)
     };
     VkShaderModule shader_module;
     if (vkCreateShaderModule(device, &create_info, nullptr, &shader_module) !=
@@ -574,12 +726,53 @@ VkShaderModule VulkanApplication::create_shader_module(
     return shader_module;
 }
 
+void VulkanApplication::open_asset_pack() {
+    CPU_ZONE_FUNCTION();
+    if (!options.asset_pack_path.empty()) {
+        asset_pack.open(options.asset_pack_path);
+    }
+}
+
+void VulkanApplication::load_shaders() {
+    CPU_ZONE_FUNCTION();
+    // pack entries are used in place, loose files are read into memory
+    auto load = [&](char const *path, std::vector<char> &code) {
+        auto view = asset_pack.find(path, ASSET_SHADER);
+        if (view.data) {
+            return view;
+        }
+        std::string file = path;
+#ifdef SHADER_BUILD_DIR
+        // compiled by the build, newer than the prebuilt copy in shaders/
+        auto built = std::string(SHADER_BUILD_DIR) + "/" + path;
+        if (std::filesystem::exists(built)) {
+            file = built;
+        }
+#endif
+        code = read_file(file);
+        return AssetView{.data = code.data(), .size = code.size()};
+    };
+    char const *vert_path = "shaders/vert.spv";
+    if (options.render_mode == RENDER_MODE_INSTANCED) {
+        vert_path = "shaders/instanced.spv";
+    } else if (options.render_mode == RENDER_MODE_INDIRECT) {
+        vert_path = "shaders/indirect.spv";
+    }
+    vert_shader = load(vert_path, vert_shader_code);
+    frag_shader = load("shaders/frag.spv", frag_shader_code);
+    if (options.gpu_culling) {
+        cull_shader = load("shaders/cull.spv", cull_shader_code);
+    }
+}
+
 void VulkanApplication::create_graphics_pipeline() {
-    auto vert_shader_code = read_file("shaders/vert.spv");
-    auto frag_shader_code = read_file("shaders/frag.spv");
+    CPU_ZONE_FUNCTION();
+    if (!vert_shader.data || !frag_shader.data) {
+        load_shaders();
+    }
 
-    auto vert_shader_module = create_shader_module(vert_shader_code);
-    auto frag_shader_module = create_shader_module(frag_shader_code);
+    auto vert_shader_module = create_shader_module(vert_shader);
+    auto frag_shader_module = create_shader_module(frag_shader);
 
     VkPipelineShaderStageCreateInfo vert_shader_stage_info{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -606,13 +799,25 @@ void VulkanApplication::create_graphics_pipeline() {
     // per-vertex or per-instance level b. attribute descriptions: type, how to
     // load and offset (layout)
 
-    auto binding_description = Vertex::get_binding_description();
-    auto attribute_descriptions = Vertex::get_attribute_descriptions();
+    std::vector<VkVertexInputBindingDescription> binding_descriptions = {
+        Vertex::get_binding_description()};
+    auto vertex_attributes = Vertex::get_attribute_descriptions();
+    std::vector<VkVertexInputAttributeDescription> attribute_descriptions(
+        vertex_attributes.begin(), vertex_attributes.end());
+    // instanced mode adds the per-instance binding 1
+    if (options.render_mode == RENDER_MODE_INSTANCED) {
+        binding_descriptions.push_back(
+            InstanceData::get_binding_description());
+        auto instance_attributes = InstanceData::get_attribute_descriptions();
+        attribute_descriptions.insert(attribute_descriptions.end(),
+                                      instance_attributes.begin(),
+                                      instance_attributes.end());
+    }
 
     VkPipelineVertexInputStateCreateInfo vertex_input_info{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount = 1,
-        .pVertexBindingDescriptions = &binding_description,  // details
+        .vertexBindingDescriptionCount = (uint32_t)binding_descriptions.size(),
+        .pVertexBindingDescriptions = binding_descriptions.data(),  // details
         .vertexAttributeDescriptionCount =
             (uint32_t)attribute_descriptions.size(),
         .pVertexAttributeDescriptions = attribute_descriptions.data()};
@@ -626,22 +831,14 @@ void VulkanApplication::create_graphics_pipeline() {
             VK_FALSE  // set special index 0xffff to break up primitives
     };
 
-    // 3. Viewports and Scissors: defines framebuffer region
-    VkViewport viewport{.x = 0.0f,
-                        .y = 0.0f,
-                        .width = (float)swapchain_extent.width,
-                        .height = (float)swapchain_extent.height,
-                        .minDepth = 0.0f,
-                        .maxDepth = 1.0};
-
-    VkRect2D scissor{.offset{0, 0}, .extent = swapchain_extent};
-
+    // 3. Viewports and Scissors: defines framebuffer region, both are dynamic
+    // and set at record time so the pipeline does not depend on the extent
     VkPipelineViewportStateCreateInfo viewport_state{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
         .viewportCount = 1,  // multiple viewports need GPU support
-        .pViewports = &viewport,
+        .pViewports = nullptr,
         .scissorCount = 1,
-        .pScissors = &scissor};
+        .pScissors = nullptr};
 
     // 4. Rasterizer: break primitives into pixels (fragments) to be colored by
     // fragment shader
@@ -708,19 +905,23 @@ void VulkanApplication::create_graphics_pipeline() {
     // 8. Dynamic State: set dynamic state in pipeline (change without
     // recreating the pipeline)
     std::vector<VkDynamicState> dynamic_states = {VK_DYNAMIC_STATE_VIEWPORT,
-                                                  VK_DYNAMIC_STATE_LINE_WIDTH};
+                                                  VK_DYNAMIC_STATE_SCISSOR};
     VkPipelineDynamicStateCreateInfo dynamic_state_info{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
         .dynamicStateCount = static_cast<uint32_t>(dynamic_states.size()),
         .pDynamicStates = dynamic_states.data()};
 
-    // 9. Pipeline Layout:  dynamic state variables settings (uniform)
+    // 9. Pipeline Layout:  dynamic state variables settings (uniform), the
+    // per draw model matrix and material come as push constants
+    VkPushConstantRange push_range{.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                                   .offset = 0,
+                                   .size = sizeof(DrawConstants)};
     VkPipelineLayoutCreateInfo pipeline_layout_info{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .setLayoutCount = 1,
         .pSetLayouts = &descriptor_set_layout,
-        .pushConstantRangeCount = 0,
-        .pPushConstantRanges = nullptr};
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_range};
 
     if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr,
                                &pipeline_layout) != VK_SUCCESS) {
@@ -738,8 +939,7 @@ void VulkanApplication::create_graphics_pipeline() {
         .pMultisampleState = &multisampling,
         .pDepthStencilState = nullptr,
         .pColorBlendState = &color_bending,
-        // .pDynamicState = &dynamic_state_info,
-        .pDynamicState = nullptr,
+        .pDynamicState = &dynamic_state_info,
         .layout = pipeline_layout,
         .renderPass = render_pass,
         .subpass = 0,
@@ -748,17 +948,94 @@ void VulkanApplication::create_graphics_pipeline() {
 
     // can create multiple pipelines once
     // VkPipelineCache used to store and reuse data to pipeline creation across
-    // multiple calls (speedups)
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_info,
-                                  nullptr, &graphics_pipeline) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create graphics pipeline!");
+    // multiple calls (speedups), ours is persisted between runs
+    auto compile_start = std::chrono::steady_clock::now();
+    {
+        CPU_ZONE("vkCreateGraphicsPipelines");
+        if (vkCreateGraphicsPipelines(device, pipeline_cache.handle(), 1,
+                                      &pipeline_info, nullptr,
+                                      &graphics_pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create graphics pipeline!");
+        }
     }
+    graphics_compile_ms = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - compile_start)
+                              .count();
 
     vkDestroyShaderModule(device, frag_shader_module, nullptr);
     vkDestroyShaderModule(device, vert_shader_module, nullptr);
 }
 
+// first compute pipeline: frustum culls the indirect commands before the
+// render pass, see shaders/cull.comp
+void VulkanApplication::create_cull_pipeline() {
+    CPU_ZONE_FUNCTION();
+    if (!options.gpu_culling) {
+        return;
+    }
+    if (!cull_shader.data) {
+        load_shaders();
+    }
+
+    // 0 objects, 1 commands, 2 spheres, 3 visible commands, 4 counts
+    std::array<VkDescriptorSetLayoutBinding, 5> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); ++i) {
+        bindings[i] = {.binding = i,
+                       .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                       .descriptorCount = 1,
+                       .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT};
+    }
+    VkDescriptorSetLayoutCreateInfo layout_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = (uint32_t)bindings.size(),
+        .pBindings = bindings.data()};
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr,
+                                    &cull_set_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create cull set layout!");
+    }
+
+    // the frustum changes every frame, it travels as push constants
+    VkPushConstantRange push_range{.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                                   .offset = 0,
+                                   .size = sizeof(CullParams)};
+    VkPipelineLayoutCreateInfo pipeline_layout_info{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &cull_set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_range};
+    if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr,
+                               &cull_pipeline_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create cull pipeline layout!");
+    }
+
+    auto cull_shader_module = create_shader_module(cull_shader);
+    VkComputePipelineCreateInfo pipeline_info{
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                  .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                  .module = cull_shader_module,
+                  .pName = "main"},
+        .layout = cull_pipeline_layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1};
+    auto compile_start = std::chrono::steady_clock::now();
+    {
+        CPU_ZONE("vkCreateComputePipelines");
+        if (vkCreateComputePipelines(device, pipeline_cache.handle(), 1,
+                                     &pipeline_info, nullptr,
+                                     &cull_pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create cull pipeline!");
+        }
+    }
+    cull_compile_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - compile_start)
+                          .count();
+    vkDestroyShaderModule(device, cull_shader_module, nullptr);
+}
+
 void VulkanApplication::create_framebuffers() {
+    CPU_ZONE_FUNCTION();
     swapchain_framebuffers.resize(swapchain_image_views.size());
     for (size_t i = 0; i < swapchain_image_views.size(); ++i) {
         VkImageView attachments[] = {swapchain_image_views[i]};
@@ -780,48 +1057,69 @@ void VulkanApplication::create_framebuffers() {
 }
 
 void VulkanApplication::create_command_pool() {
+    CPU_ZONE_FUNCTION();
     QueueFamilyIndices queue_family_indices =
         find_queue_families(physical_device);
-    VkCommandPoolCreateInfo pool_info{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-        .queueFamilyIndex = queue_family_indices.graphics_family.value()
-        // each cmd pool can alloc cmd buffers that submit to a single type of
-        // queue
-    };
+    // one transient pool per frame slot, reset wholesale with
+    // vkResetCommandPool once the slot's previous frame has finished
+    frame_command_pools.resize(frames_in_flight);
+    for (auto &pool : frame_command_pools) {
+        VkCommandPoolCreateInfo pool_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = queue_family_indices.graphics_family.value()
+            // each cmd pool can alloc cmd buffers that submit to a single type
+            // of queue
+        };
 
-    if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) !=
-        VK_SUCCESS) {
-        throw std::runtime_error("failed to create command pool!");
+        if (vkCreateCommandPool(device, &pool_info, nullptr, &pool) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create command pool!");
+        }
     }
 
-    VkCommandPoolCreateInfo transfer_pool_info{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-        .queueFamilyIndex = queue_family_indices.transfer_family.value()};
+    one_time_commands.init(device, graphics_queue,
+                           queue_family_indices.graphics_family.value());
+    frame_profiler.init(physical_device, device,
+                        queue_family_indices.graphics_family.value(),
+                        frames_in_flight, host_query_reset, "graphics");
+}
 
-    if (vkCreateCommandPool(device, &transfer_pool_info, nullptr,
-                            &transfer_command_pool) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create transfer command pool!");
+void VulkanApplication::create_staging_uploader() {
+    CPU_ZONE_FUNCTION();
+    QueueFamilyIndices queue_family_indices =
+        find_queue_families(physical_device);
+    staging_uploader.init(device, &allocator, transfer_queue,
+                          queue_family_indices.transfer_family.value());
+    upload_profiler.init(physical_device, device,
+                         queue_family_indices.transfer_family.value(),
+                         StagingUploader::MAX_BATCHES, host_query_reset,
+                         "upload");
+    if (upload_profiler.is_enabled()) {
+        staging_uploader.set_profiler(&upload_profiler);
     }
 }
 
 void VulkanApplication::create_command_buffer() {
-    command_buffers.resize(MAX_FRAMES_IN_FLIGHT);
-    VkCommandBufferAllocateInfo alloc_info{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool = command_pool,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,  // for reuse common op
-        .commandBufferCount = (uint32_t)command_buffers.size()};
-
-    if (vkAllocateCommandBuffers(device, &alloc_info, command_buffers.data()) !=
-        VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate command buffers!");
+    CPU_ZONE_FUNCTION();
+    command_buffers.resize(frames_in_flight);
+    for (size_t i = 0; i < frames_in_flight; ++i) {
+        VkCommandBufferAllocateInfo alloc_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = frame_command_pools[i],
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,  // for reuse common op
+            .commandBufferCount = 1};
+
+        if (vkAllocateCommandBuffers(device, &alloc_info,
+                                     &command_buffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate command buffers!");
+        }
     }
 }
 
 void VulkanApplication::record_command_buffer(VkCommandBuffer command_buffer,
                                               uint32_t image_index) {
+    CPU_ZONE_FUNCTION();
     VkCommandBufferBeginInfo begin_info{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .flags = 0,
@@ -830,6 +1128,9 @@ void VulkanApplication::record_command_buffer(VkCommandBuffer command_buffer,
     if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
         throw std::runtime_error("failed to begin recording command buffer!");
     }
+    // the slot's previous frame has completed, its timestamps are ready
+    frame_profiler.begin_frame(current_frame, frame_count + 1);
+    auto frame_zone = frame_profiler.begin_zone(command_buffer, "frame");
 
     VkClearValue clear_color = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
 
@@ -844,111 +1145,674 @@ void VulkanApplication::record_command_buffer(VkCommandBuffer command_buffer,
         .clearValueCount = 1,
         .pClearValues = &clear_color};
 
-    vkCmdBeginRenderPass(command_buffer, &render_pass_info,
-                         VK_SUBPASS_CONTENTS_INLINE);
+    auto record_start = std::chrono::steady_clock::now();
+    // compute work has to happen outside of the render pass
+    if (options.gpu_culling) {
+        auto cull_zone = frame_profiler.begin_zone(command_buffer, "culling");
+        record_culling(command_buffer);
+        frame_profiler.end_zone(command_buffer, cull_zone,
+                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    }
+    auto pass_zone = frame_profiler.begin_zone(command_buffer, "render pass");
+    if (options.render_mode != RENDER_MODE_PER_OBJECT) {
+        // a handful of draws, not worth spreading over record jobs
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info,
+                             VK_SUBPASS_CONTENTS_INLINE);
+        if (options.render_mode == RENDER_MODE_INSTANCED) {
+            record_instanced(command_buffer);
+        } else {
+            record_indirect(command_buffer);
+        }
+    } else if (record_jobs == 0) {
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info,
+                             VK_SUBPASS_CONTENTS_INLINE);
+        record_draws(command_buffer, 0, (uint32_t)draw_constants.size());
+    } else {
+        // every job fills its own secondary buffer from its own pool, the
+        // primary only stitches them together
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info,
+                             VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        record_workers.parallel_for(
+            record_jobs, [&](uint32_t job, uint32_t worker) {
+                record_secondary(job, image_index);
+            });
+        vkCmdExecuteCommands(
+            command_buffer, record_jobs,
+            &secondary_command_buffers[current_frame * max_record_jobs]);
+    }
+    record_time_ms += std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - record_start)
+                          .count();
+
+    vkCmdEndRenderPass(command_buffer);
+    frame_profiler.end_zone(command_buffer, pass_zone,
+                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    frame_profiler.end_zone(command_buffer, frame_zone);
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
 
+void VulkanApplication::record_draws(VkCommandBuffer command_buffer,
+                                     uint32_t first, uint32_t count) {
     vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                       graphics_pipeline);
+
+    VkViewport viewport{.x = 0.0f,
+                        .y = 0.0f,
+                        .width = (float)swapchain_extent.width,
+                        .height = (float)swapchain_extent.height,
+                        .minDepth = 0.0f,
+                        .maxDepth = 1.0f};
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    VkRect2D scissor{.offset{0, 0}, .extent = swapchain_extent};
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
     VkBuffer vertex_buffers[] = {vertex_buffer};
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
-    vkCmdBindIndexBuffer(command_buffer, index_buffer, 0, VK_INDEX_TYPE_UINT16);
+    // view and projection once, everything per draw is pushed
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pipeline_layout, 0, 1,
+                            &descriptor_sets[current_frame], 1,
+                            &uniform_offset);
+
+    // the shared index buffer is only rebound when the index width changes
+    bool index_bound = false;
+    VkIndexType bound_type = VK_INDEX_TYPE_UINT16;
+    for (uint32_t i = first; i < first + count; ++i) {
+        auto const &mesh = meshes.mesh(scene_objects[draw_objects[i]].mesh);
+        if (!index_bound || mesh.index_type != bound_type) {
+            vkCmdBindIndexBuffer(command_buffer, index_buffer, 0,
+                                 mesh.index_type);
+            index_bound = true;
+            bound_type = mesh.index_type;
+        }
+        vkCmdPushConstants(command_buffer, pipeline_layout,
+                           VK_SHADER_STAGE_VERTEX_BIT, 0,
+                           sizeof(DrawConstants), &draw_constants[i]);
+        vkCmdDrawIndexed(command_buffer, mesh.index_count, 1, mesh.first_index,
+                         mesh.vertex_offset, 0);
+    }
+}
+
+// one draw per mesh batch, instance i reads its transform from slot i of
+// this frame's slice of the instance buffer
+void VulkanApplication::record_instanced(VkCommandBuffer command_buffer) {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      graphics_pipeline);
 
+    VkViewport viewport{.x = 0.0f,
+                        .y = 0.0f,
+                        .width = (float)swapchain_extent.width,
+                        .height = (float)swapchain_extent.height,
+                        .minDepth = 0.0f,
+                        .maxDepth = 1.0f};
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    VkRect2D scissor{.offset{0, 0}, .extent = swapchain_extent};
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+    VkBuffer vertex_buffers[] = {vertex_buffer, instance_buffer};
+    VkDeviceSize offsets[] = {0, current_frame * instance_slice};
+    vkCmdBindVertexBuffers(command_buffer, 0, 2, vertex_buffers, offsets);
+    // view and projection only, the model matrix comes per instance
     vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                             pipeline_layout, 0, 1,
-                            &descriptor_sets[current_frame], 0, nullptr);
-    vkCmdDrawIndexed(command_buffer, (uint32_t)indices.size(), 1, 0, 0, 0);
-    // vkCmdDraw(command_buffer, (uint32_t)vertices.size(), 1, 0, 0);
+                            &descriptor_sets[current_frame], 1,
+                            &uniform_offset);
+
+    bool index_bound = false;
+    VkIndexType bound_type = VK_INDEX_TYPE_UINT16;
+    for (auto const &batch : instance_batches) {
+        auto const &mesh = meshes.mesh(batch.mesh);
+        if (!index_bound || mesh.index_type != bound_type) {
+            vkCmdBindIndexBuffer(command_buffer, index_buffer, 0,
+                                 mesh.index_type);
+            index_bound = true;
+            bound_type = mesh.index_type;
+        }
+        vkCmdDrawIndexed(command_buffer, mesh.index_count,
+                         batch.instance_count, mesh.first_index,
+                         mesh.vertex_offset, batch.first_instance);
+    }
+}
+
+// the CPU cost is one call per index type no matter how many objects there
+// are, the per-object work lives in indirect_buffer
+void VulkanApplication::record_indirect(VkCommandBuffer command_buffer) {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      graphics_pipeline);
+
+    VkViewport viewport{.x = 0.0f,
+                        .y = 0.0f,
+                        .width = (float)swapchain_extent.width,
+                        .height = (float)swapchain_extent.height,
+                        .minDepth = 0.0f,
+                        .maxDepth = 1.0f};
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    VkRect2D scissor{.offset{0, 0}, .extent = swapchain_extent};
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+    VkBuffer vertex_buffers[] = {vertex_buffer};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
+    // the frame's slice of the object buffer is baked into its set
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pipeline_layout, 0, 1,
+                            &descriptor_sets[current_frame], 1,
+                            &uniform_offset);
+
+    // culling replaces the static commands with this frame's survivors
+    VkBuffer draw_buffer = indirect_buffer;
+    VkDeviceSize draw_offset = 0;
+    VkBuffer count_buffer = indirect_count_buffer;
+    VkDeviceSize count_offset = 0;
+    if (options.gpu_culling) {
+        draw_buffer = visible_buffer;
+        draw_offset = current_frame * visible_slice;
+        count_buffer = cull_count_buffer;
+        count_offset = current_frame * cull_count_slice;
+    }
+
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    for (uint32_t i = 0; i < indirect_batches.size(); ++i) {
+        auto const &batch = indirect_batches[i];
+        vkCmdBindIndexBuffer(command_buffer, index_buffer, 0,
+                             batch.index_type);
+        VkDeviceSize offset = draw_offset + batch.first_command * stride;
+        if (indirect_count_draws) {
+            // the count is read on the GPU, capped by command_count
+            vkCmdDrawIndexedIndirectCount(
+                command_buffer, draw_buffer, offset, count_buffer,
+                count_offset + i * sizeof(uint32_t), batch.command_count,
+                stride);
+            continue;
+        }
+        // chunks of at most maxDrawIndirectCount commands, 1 without
+        // multiDrawIndirect
+        for (uint32_t first = 0; first < batch.command_count;
+             first += max_draw_indirect_count) {
+            auto count =
+                std::min(max_draw_indirect_count, batch.command_count - first);
+            vkCmdDrawIndexedIndirect(command_buffer, draw_buffer,
+                                     offset + first * stride, count, stride);
+        }
+    }
+}
+
+void VulkanApplication::record_culling(VkCommandBuffer command_buffer) {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      cull_pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            cull_pipeline_layout, 0, 1,
+                            &cull_descriptor_sets[current_frame], 0, nullptr);
+    vkCmdPushConstants(command_buffer, cull_pipeline_layout,
+                       VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullParams),
+                       &cull_params);
+    // one invocation per command, 64 per workgroup as in cull.comp
+    vkCmdDispatch(command_buffer, (cull_params.command_count + 63) / 64, 1,
+                  1);
+
+    // the draws read what the dispatch wrote
+    std::array<VkBufferMemoryBarrier, 2> barriers{};
+    VkBuffer buffers[] = {visible_buffer, cull_count_buffer};
+    VkDeviceSize offsets[] = {current_frame * visible_slice,
+                              current_frame * cull_count_slice};
+    VkDeviceSize sizes[] = {visible_slice, cull_count_slice};
+    for (uint32_t i = 0; i < barriers.size(); ++i) {
+        barriers[i] = {.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                       .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+                       .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                       .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                       .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                       .buffer = buffers[i],
+                       .offset = offsets[i],
+                       .size = sizes[i]};
+    }
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr,
+                         (uint32_t)barriers.size(), barriers.data(), 0,
+                         nullptr);
+    // collect_cull_counts reads the counts once the frame has finished
+    VkBufferMemoryBarrier host_barrier{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = cull_count_buffer,
+        .offset = current_frame * cull_count_slice,
+        .size = cull_count_slice};
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1,
+                         &host_barrier, 0, nullptr);
+}
+
+void VulkanApplication::record_secondary(uint32_t job, uint32_t image_index) {
+    CPU_ZONE_FUNCTION();
+    auto slot = current_frame * max_record_jobs + job;
+    auto command_buffer = secondary_command_buffers[slot];
+    // the pool only ever holds this one buffer, resetting it is the cheapest
+    // way to recycle the memory of the frame it recorded last time
+    vkResetCommandPool(device, secondary_command_pools[slot], 0);
+
+    VkCommandBufferInheritanceInfo inheritance_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = render_pass,
+        .subpass = 0,
+        .framebuffer = swapchain_framebuffers[image_index]};
+    VkCommandBufferBeginInfo begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                 VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritance_info};
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin secondary command buffer!");
+    }
+
+    // contiguous slice of the draw list, the last job takes the remainder
+    auto draw_count = (uint32_t)draw_constants.size();
+    auto per_job = draw_count / record_jobs;
+    auto first = job * per_job;
+    auto count = job + 1 == record_jobs ? draw_count - first : per_job;
+    record_draws(command_buffer, first, count);
 
-    vkCmdEndRenderPass(command_buffer);
     if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
-        throw std::runtime_error("failed to record command buffer!");
+        throw std::runtime_error("failed to record secondary command buffer!");
     }
 }
 
+void VulkanApplication::create_secondary_command_buffers() {
+    CPU_ZONE_FUNCTION();
+    max_record_jobs = options.record_threads;
+    if (options.record_benchmark) {
+        max_record_jobs =
+            std::max(max_record_jobs, std::thread::hardware_concurrency());
+    }
+    record_jobs = options.record_threads;
+    if (max_record_jobs == 0) {
+        return;
+    }
+    record_workers.init(max_record_jobs);
+
+    auto graphics_family =
+        find_queue_families(physical_device).graphics_family.value();
+    secondary_command_pools.resize(frames_in_flight * max_record_jobs);
+    secondary_command_buffers.resize(frames_in_flight * max_record_jobs);
+    for (size_t i = 0; i < secondary_command_pools.size(); ++i) {
+        // command pools are externally synchronized, one per (frame, job)
+        VkCommandPoolCreateInfo pool_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = graphics_family};
+        if (vkCreateCommandPool(device, &pool_info, nullptr,
+                                &secondary_command_pools[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create record command pool!");
+        }
+        VkCommandBufferAllocateInfo alloc_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = secondary_command_pools[i],
+            .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = 1};
+        if (vkAllocateCommandBuffers(device, &alloc_info,
+                                     &secondary_command_buffers[i]) !=
+            VK_SUCCESS) {
+            throw std::runtime_error(
+                "failed to allocate secondary command buffers!");
+        }
+    }
+}
+
+// records frame slot 0 against swapchain image 0 with 0..N record jobs and
+// prints the average host cost, nothing is submitted
+void VulkanApplication::benchmark_recording() {
+    CPU_ZONE_FUNCTION();
+    const uint32_t iterations = 32;
+    update_uniform_buffer(0);
+
+    std::vector<uint32_t> job_counts = {0};
+    for (uint32_t jobs = 1; jobs <= max_record_jobs; jobs *= 2) {
+        job_counts.push_back(jobs);
+    }
+    if (job_counts.back() != max_record_jobs) {
+        job_counts.push_back(max_record_jobs);
+    }
+
+    std::cout << "record benchmark: " << draws_per_frame << " draws, "
+              << iterations << " iterations\n";
+    double baseline_ms = 0.0;
+    for (auto jobs : job_counts) {
+        record_jobs = jobs;
+        record_time_ms = 0.0;
+        for (uint32_t i = 0; i < iterations; ++i) {
+            vkResetCommandPool(device, frame_command_pools[0], 0);
+            record_command_buffer(command_buffers[0], 0);
+        }
+        auto average_ms = record_time_ms / iterations;
+        if (jobs == 0) {
+            baseline_ms = average_ms;
+        }
+        std::cout << "  " << (jobs == 0 ? "inline" : "threads ")
+                  << (jobs == 0 ? std::string() : std::to_string(jobs)) << ": "
+                  << average_ms << " ms, speedup " << baseline_ms / average_ms
+                  << "x\n";
+    }
+    vkResetCommandPool(device, frame_command_pools[0], 0);
+    record_jobs = options.record_threads;
+    record_time_ms = 0.0;
+    cull_time_ms = 0.0;
+    cull_stats = {};
+}
+
 void VulkanApplication::create_sync_objects() {
-    image_available_semaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    render_finished_semaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    in_flight_fences.resize(MAX_FRAMES_IN_FLIGHT);
+    CPU_ZONE_FUNCTION();
+    image_available_semaphores.resize(options.headless ? 0 : frames_in_flight);
 
     VkSemaphoreCreateInfo semaphore_info{
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
-    VkFenceCreateInfo fence_info{.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-                                 .flags = VK_FENCE_CREATE_SIGNALED_BIT};
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+    for (size_t i = 0; i < image_available_semaphores.size(); ++i) {
         if (vkCreateSemaphore(device, &semaphore_info, nullptr,
-                              &image_available_semaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(device, &semaphore_info, nullptr,
-                              &render_finished_semaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(device, &fence_info, nullptr, &in_flight_fences[i]) !=
-                VK_SUCCESS) {
-            throw std::runtime_error("failed to create semaphores or fence!");
+                              &image_available_semaphores[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create semaphores!");
         }
     }
+
+    // frame N signals value N when its command buffer finished, replaces the
+    // per frame fences
+    VkSemaphoreTypeCreateInfo timeline_info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0};
+    VkSemaphoreCreateInfo timeline_semaphore_info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timeline_info};
+    if (vkCreateSemaphore(device, &timeline_semaphore_info, nullptr,
+                          &frame_timeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create frame timeline!");
+    }
+
+    create_present_semaphores();
+}
+
+// presentation still needs binary semaphores, one per swapchain image so a
+// semaphore is never re-signaled while the presentation engine waits on it
+void VulkanApplication::create_present_semaphores() {
+    if (options.headless) {
+        return;
+    }
+    render_finished_semaphores.resize(swapchain_images.size());
+    VkSemaphoreCreateInfo semaphore_info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    for (auto &semaphore : render_finished_semaphores) {
+        if (vkCreateSemaphore(device, &semaphore_info, nullptr, &semaphore) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create present semaphore!");
+        }
+    }
+}
+
+uint64_t VulkanApplication::poll_completed_frame() {
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(device, frame_timeline, &value);
+    completed_frame = std::max(completed_frame, value);
+    return completed_frame;
+}
+
+void VulkanApplication::wait_for_frame(uint64_t frame) {
+    CPU_ZONE_FUNCTION();
+    if (frame <= completed_frame) {
+        return;
+    }
+    VkSemaphoreWaitInfo wait_info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &frame_timeline,
+        .pValues = &frame};
+    if (vkWaitSemaphores(device, &wait_info, UINT64_MAX) != VK_SUCCESS) {
+        throw std::runtime_error("failed to wait for frame timeline!");
+    }
+    completed_frame = frame;
 }
 
 void VulkanApplication::init_vulkan() {
-    create_instance();
-    setup_debug_messenger();
-    create_surface();
-    pick_physical_device();
-    create_logical_device();
-    create_swapchain();
-    create_image_views();
-    create_render_pass();
-    create_descriptor_set_layout();  // set memory layout first
-    create_graphics_pipeline();
-    create_framebuffers();
-    create_command_pool();
-    create_texture_image();
-    create_texture_image_view();
-    create_texture_sampler();
-    create_vertex_buffer();
-    create_index_buffer();
-    create_uniform_buffers();
-    create_descriptor_pool();
-    create_descriptor_sets();
-    create_command_buffer();
-    create_sync_objects();
+    CPU_ZONE_FUNCTION();
+    auto init_start = std::chrono::steady_clock::now();
+
+    // file reads and decoding overlap device creation, the Vulkan objects
+    // only wait for what they actually reference
+    TaskGraph graph;
+    auto pack = graph.add("open_asset_pack", [&]() { open_asset_pack(); });
+    auto shader_files =
+        graph.add("load_shaders", [&]() { load_shaders(); }, {pack});
+    auto mesh_files =
+        graph.add("load_meshes", [&]() { load_meshes(); }, {pack});
+    auto scene =
+        graph.add("create_scene", [&]() { create_scene(); }, {mesh_files});
+    // SDL/window system calls stay on the main thread
+    auto instance =
+        graph.add("create_instance", [&]() { create_instance(); }, {}, true);
+    auto debug = graph.add(
+        "setup_debug_messenger", [&]() { setup_debug_messenger(); },
+        {instance});
+    auto surface = graph.add(
+        "create_surface", [&]() { create_surface(); }, {instance}, true);
+    auto physical = graph.add(
+        "pick_physical_device", [&]() { pick_physical_device(); },
+        {instance, surface});
+    auto device = graph.add(
+        "create_logical_device", [&]() { create_logical_device(); },
+        {physical, debug});
+    auto targets = graph.add(
+        "create_targets",
+        [&]() {
+            if (options.headless) {
+                create_offscreen_targets();
+            } else {
+                create_swapchain();
+            }
+        },
+        {device});
+    auto image_views = graph.add(
+        "create_image_views", [&]() { create_image_views(); }, {targets});
+    auto render_pass = graph.add(
+        "create_render_pass", [&]() { create_render_pass(); }, {targets});
+    auto set_layout = graph.add(
+        "create_descriptor_set_layout",
+        [&]() { create_descriptor_set_layout(); }, {device});
+    graph.add(
+        "create_graphics_pipeline", [&]() { create_graphics_pipeline(); },
+        {render_pass, set_layout, shader_files});
+    auto cull_pipeline = graph.add(
+        "create_cull_pipeline", [&]() { create_cull_pipeline(); },
+        {device, shader_files});
+    graph.add(
+        "create_framebuffers", [&]() { create_framebuffers(); },
+        {image_views, render_pass});
+    auto command_pool = graph.add(
+        "create_command_pool", [&]() { create_command_pool(); }, {device});
+    auto uploader = graph.add(
+        "create_staging_uploader", [&]() { create_staging_uploader(); },
+        {device});
+    auto texture = graph.add(
+        "create_texture_image", [&]() { create_texture_image(); },
+        {uploader});
+    auto texture_view = graph.add(
+        "create_texture_image_view", [&]() { create_texture_image_view(); },
+        {texture});
+    graph.add(
+        "create_texture_streamer", [&]() { create_texture_streamer(); },
+        {uploader, command_pool, pack});
+    auto sampler = graph.add(
+        "create_texture_sampler", [&]() { create_texture_sampler(); },
+        {device});
+    graph.add(
+        "create_mesh_buffers", [&]() { create_mesh_buffers(); },
+        {uploader, mesh_files});
+    auto uniforms = graph.add(
+        "create_uniform_buffers", [&]() { create_uniform_buffers(); },
+        {device, scene});
+    auto descriptor_pool = graph.add(
+        "create_descriptor_pool", [&]() { create_descriptor_pool(); },
+        {device});
+    auto instances = graph.add(
+        "create_instance_buffer", [&]() { create_instance_buffer(); },
+        {device, scene});
+    auto indirect = graph.add(
+        "create_indirect_buffers", [&]() { create_indirect_buffers(); },
+        {uploader, scene});
+    auto cull_buffers = graph.add(
+        "create_cull_buffers", [&]() { create_cull_buffers(); },
+        {indirect});
+    graph.add(
+        "create_cull_descriptor_sets",
+        [&]() { create_cull_descriptor_sets(); },
+        {cull_pipeline, cull_buffers, instances});
+    graph.add(
+        "create_descriptor_sets", [&]() { create_descriptor_sets(); },
+        {descriptor_pool, set_layout, uniforms, instances, texture_view,
+         sampler});
+    graph.add(
+        "create_command_buffer", [&]() { create_command_buffer(); },
+        {command_pool});
+    graph.add(
+        "create_secondary_command_buffers",
+        [&]() { create_secondary_command_buffers(); }, {device});
+    graph.add(
+        "create_sync_objects", [&]() { create_sync_objects(); }, {targets});
+
+    ThreadPool init_workers;
+    if (!options.serial_init) {
+        init_workers.init(
+            std::min(std::thread::hardware_concurrency(), MAX_INIT_THREADS));
+    }
+    graph.run(init_workers);
+    init_workers.destroy();
+    graph.print_summary(std::cout);
+    graph.print_timeline(std::cout);
+
+    if (options.record_benchmark) {
+        benchmark_recording();
+    }
+
+    // kick off every recorded upload at once, frames wait on it lazily
+    upload_ticket = staging_uploader.flush();
+
+    auto init_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - init_start)
+                       .count();
+    std::cout << "startup: " << init_ms << " ms, pipeline compile "
+              << graphics_compile_ms + cull_compile_ms << " ms ("
+              << (pipeline_cache.is_warm() ? "warm" : "cold") << " cache, "
+              << pipeline_cache.loaded_size() << " bytes loaded)\n";
 }
 
+// only the extent dependent objects, pipeline and render pass survive resizes
 void VulkanApplication::cleanup_swapchain() {
     for (auto framebuffer : swapchain_framebuffers) {
         vkDestroyFramebuffer(device, framebuffer, nullptr);
     }
-    vkDestroyPipeline(device, graphics_pipeline, nullptr);
-    vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
-    vkDestroyRenderPass(device, render_pass, nullptr);
+    swapchain_framebuffers.clear();
     for (auto image_view : swapchain_image_views) {
         vkDestroyImageView(device, image_view, nullptr);
     }
+    swapchain_image_views.clear();
+    if (options.headless) {
+        for (size_t i = 0; i < swapchain_images.size(); ++i) {
+            destroy_image(swapchain_images[i], offscreen_allocations[i]);
+        }
+        swapchain_images.clear();
+        return;
+    }
     vkDestroySwapchainKHR(device, swapchain, nullptr);
 }
 
-void VulkanApplication::recreate_swapchain() {
-    /*SDL_Vulkan_GetDrawableSize(window, &width, &height);
-    while (width == 0 || height == 0) {
-      SDL_Vulkan_GetDrawableSize(window, &width, &height);
-      SDL_WaitEvent(nullptr);
-    }*/
+void VulkanApplication::cleanup_pipeline() {
+    vkDestroyPipeline(device, graphics_pipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+    vkDestroyRenderPass(device, render_pass, nullptr);
+}
 
-    vkDeviceWaitIdle(device);
-    create_swapchain();
+void VulkanApplication::recreate_swapchain() {
+    CPU_ZONE_FUNCTION();
+    // frames still in flight keep using the old images, so instead of
+    // draining the GPU the old objects are retired and destroyed once every
+    // frame submitted so far has finished
+    auto old_swapchain = swapchain;
+    auto old_format = swapchain_image_format;
+    if (!create_swapchain(old_swapchain)) {
+        return;
+    }
+    deletion_queue.push(
+        frame_count, 0,
+        [device = device, old_swapchain,
+         image_views = std::move(swapchain_image_views),
+         framebuffers = std::move(swapchain_framebuffers),
+         semaphores = std::move(render_finished_semaphores)]() {
+            for (auto semaphore : semaphores) {
+                vkDestroySemaphore(device, semaphore, nullptr);
+            }
+            for (auto framebuffer : framebuffers) {
+                vkDestroyFramebuffer(device, framebuffer, nullptr);
+            }
+            for (auto image_view : image_views) {
+                vkDestroyImageView(device, image_view, nullptr);
+            }
+            vkDestroySwapchainKHR(device, old_swapchain, nullptr);
+        });
+    swapchain_image_views.clear();
+    swapchain_framebuffers.clear();
+    render_finished_semaphores.clear();
     create_image_views();
-    create_render_pass();
-    create_graphics_pipeline();
+    create_present_semaphores();
+    // viewport and scissor are dynamic, the render pass (and the pipeline
+    // built against it) only has to change with the surface format
+    if (swapchain_image_format != old_format) {
+        deletion_queue.push(
+            frame_count, 0,
+            [device = device, pipeline = graphics_pipeline,
+             layout = pipeline_layout, pass = render_pass]() {
+                vkDestroyPipeline(device, pipeline, nullptr);
+                vkDestroyPipelineLayout(device, layout, nullptr);
+                vkDestroyRenderPass(device, pass, nullptr);
+            });
+        create_render_pass();
+        create_graphics_pipeline();
+    }
     create_framebuffers();
 }
 
+void VulkanApplication::retire_buffer(VkBuffer &buffer,
+                                      Allocation &buffer_allocation) {
+    deletion_queue.push(
+        frame_count, buffer_allocation.size,
+        [this, buffer, allocation = buffer_allocation]() mutable {
+            destroy_buffer(buffer, allocation);
+        });
+    buffer = VK_NULL_HANDLE;
+    buffer_allocation = Allocation{};
+}
+
+void VulkanApplication::retire_image(VkImage &image,
+                                     Allocation &image_allocation) {
+    deletion_queue.push(
+        frame_count, image_allocation.size,
+        [this, image, allocation = image_allocation]() mutable {
+            destroy_image(image, allocation);
+        });
+    image = VK_NULL_HANDLE;
+    image_allocation = Allocation{};
+}
+
 void VulkanApplication::create_instance() {
+    CPU_ZONE_FUNCTION();
     VkApplicationInfo app_info{.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
                                .pNext = nullptr,
                                .pApplicationName = "Hello Triangle",
                                .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
                                .pEngineName = "No Engine",
                                .engineVersion = VK_MAKE_VERSION(1, 0, 0),
-                               .apiVersion = VK_API_VERSION_1_0};
+                               .apiVersion = VK_API_VERSION_1_2};
 
     if (enable_validation_layers && !check_validation_layer_support()) {
         throw std::runtime_error(
@@ -989,13 +1853,34 @@ void VulkanApplication::create_instance() {
     is_initialized = true;
 }
 
+static char const *render_mode_name(RenderMode mode) {
+    switch (mode) {
+        case RENDER_MODE_INSTANCED:
+            return "instanced";
+        case RENDER_MODE_INDIRECT:
+            return "indirect";
+        default:
+            return "per-object";
+    }
+}
+
 void VulkanApplication::main_loop() {
     SDL_Event e;
-    uint32_t duration = 0, start_time = 0, total_frames = 0;
+    uint32_t total_frames = 0;
     uint32_t milliseconds_per_frame = 16;
+    // the title is refreshed once a second, not every frame
+    auto title_time = std::chrono::steady_clock::now();
+    uint32_t title_frames = 0;
+    double title_frame_ms = 0.0;
+
+    auto frame_limit = options.frame_limit;
+    if (options.benchmark) {
+        frame_limit = options.warmup_frames + options.benchmark_frames;
+        frame_stats.reserve(options.benchmark_frames);
+    }
 
     while (is_running) {
-        while (SDL_PollEvent(&e) != 0) {
+        while (!options.headless && SDL_PollEvent(&e) != 0) {
             // start_time = SDL_GetTicks();
             // do rendering loop
             if (e.type == SDL_QUIT) is_running = false;
@@ -1006,26 +1891,134 @@ void VulkanApplication::main_loop() {
                     // "App")); app->framebuffer_resized = true;
                     framebuffer_resized = true;  // NO NEED FOR SDL2 surface
                 }
+                if (e.window.event == SDL_WINDOWEVENT_MINIMIZED) {
+                    window_minimized = true;
+                }
+                if (e.window.event == SDL_WINDOWEVENT_RESTORED) {
+                    window_minimized = false;
+                    framebuffer_resized = true;
+                }
             }
 
             //      uint32_t duration = SDL_GetTicks() - start_time;
             //      if (duration > milliseconds_per_frame) {
         }
 
-        start_time = SDL_GetTicks();
+        // zero sized surface, nothing to present until restored
+        if (window_minimized) {
+            SDL_WaitEvent(nullptr);
+            continue;
+        }
 
         draw_frame();
 
-        duration += SDL_GetTicks() - start_time;
-        float fps =
-            ++total_frames / (float)(duration == 0 ? 1 : duration) * 1000;
-        std::string title = "SDL_Vulkan_DEMO fps:" + std::to_string(fps);
-        SDL_SetWindowTitle(window, title.c_str());
+        frame_time_ms += frame_times[FRAME_PHASE_TOTAL];
+        if (options.benchmark && total_frames >= options.warmup_frames) {
+            frame_stats.add_frame(frame_times);
+        }
+        ++total_frames;
+        if (frame_limit != 0 && total_frames >= frame_limit) {
+            is_running = false;
+        }
+        if (options.headless) {
+            continue;
+        }
+
+        ++title_frames;
+        title_frame_ms += frame_times[FRAME_PHASE_TOTAL];
+        auto now = std::chrono::steady_clock::now();
+        if (now - title_time >= std::chrono::seconds(1)) {
+            float fps = title_frames /
+                        (float)std::chrono::duration<double>(now - title_time)
+                            .count();
+            std::string title = "SDL_Vulkan_DEMO fps:" + std::to_string(fps) +
+                                " cpu:" +
+                                std::to_string(title_frame_ms / title_frames) +
+                                "ms";
+            // first zone of the newest resolved frame is the whole frame
+            auto const &gpu_zones = frame_profiler.last_results();
+            if (!gpu_zones.empty()) {
+                title += " gpu:" +
+                         std::to_string(gpu_zones.front().duration_ms) + "ms";
+            }
+            SDL_SetWindowTitle(window, title.c_str());
+            title_time = now;
+            title_frames = 0;
+            title_frame_ms = 0.0;
+        }
     }
     vkDeviceWaitIdle(device);
+
+    if (total_frames > 0) {
+        std::cout << "frames in flight " << frames_in_flight << ": "
+                  << total_frames << " frames, avg cpu frame "
+                  << frame_time_ms / total_frames << " ms, avg wait on gpu "
+                  << frame_wait_ms / total_frames << " ms\n";
+        std::cout << "recording " << draws_per_frame << " draws with "
+                  << record_jobs << " jobs: avg "
+                  << record_time_ms / total_frames << " ms\n";
+    }
+    if (cull_stats.frames > 0) {
+        auto visible = (double)cull_stats.visible_objects / cull_stats.frames;
+        auto triangles =
+            (double)cull_stats.visible_triangles / cull_stats.frames;
+        std::cout << (options.cpu_culling ? "cpu" : "gpu")
+                  << " culling: avg " << visible << " of "
+                  << scene_objects.size() << " objects visible ("
+                  << 100.0 * (1.0 - visible / scene_objects.size())
+                  << "% culled), " << triangles << " of "
+                  << triangles_per_frame << " triangles submitted\n";
+        if (options.cpu_culling) {
+            std::cout << "cpu culling (" << FrustumCuller::path_name(
+                                                 cpu_culler.current_path())
+                      << "): avg " << cull_time_ms / cull_stats.frames
+                      << " ms\n";
+        }
+    }
+
+    if (options.benchmark) {
+        frame_stats.print_summary(std::cout);
+        if (!options.report_path.empty()) {
+            frame_stats.write_report(
+                options.report_path,
+                {{"frames_in_flight", std::to_string(frames_in_flight)},
+                 {"objects", std::to_string(scene_objects.size())},
+                 {"meshes", std::to_string(meshes.size())},
+                 {"triangles_per_frame", std::to_string(triangles_per_frame)},
+                 {"render_mode", render_mode_name(options.render_mode)},
+                 {"draws_per_frame", std::to_string(draws_per_frame)},
+                 {"gpu_culling", options.gpu_culling ? "true" : "false"},
+                 {"cpu_culling", options.cpu_culling ? "true" : "false"},
+                 {"scene_spread", std::to_string(options.scene_spread)},
+                 {"visible_objects",
+                  std::to_string(cull_stats.frames
+                                     ? cull_stats.visible_objects /
+                                           cull_stats.frames
+                                     : scene_objects.size())},
+                 {"visible_triangles",
+                  std::to_string(cull_stats.frames
+                                     ? cull_stats.visible_triangles /
+                                           cull_stats.frames
+                                     : triangles_per_frame)},
+                 {"record_threads", std::to_string(options.record_threads)},
+                 {"headless", options.headless ? "true" : "false"},
+                 {"warmup_frames", std::to_string(options.warmup_frames)},
+                 {"extent", std::to_string(swapchain_extent.width) + "x" +
+                                std::to_string(swapchain_extent.height)},
+                 {"mipmaps", options.mip_generation == MIP_GENERATION_NONE
+                                 ? "off"
+                                 : "on"},
+                 // the minification cost shows up on the GPU side
+                 {"gpu_frame_ms",
+                  std::to_string(frame_profiler.average_ms("frame"))}});
+            std::cout << "benchmark report written to " << options.report_path
+                      << '\n';
+        }
+    }
 }
 
 void VulkanApplication::draw_frame() {
+    CPU_ZONE_FUNCTION();
     // frame steps outline
     // 1. wait for the prev frame to finish
     // 2. acquire an image from the swap chain
@@ -1036,14 +2029,38 @@ void VulkanApplication::draw_frame() {
     // Semaphores is used to add order between queue operations
     // Fence: use it if the host needs to know when the GPU has finished
     // something (e.g. screenshot)
-    vkWaitForFences(device, 1, &in_flight_fences[current_frame], VK_TRUE,
-                    UINT64_MAX);
+    // each lap() charges the time since the previous one to a phase
+    frame_times.fill(0.0);
+    auto frame_start = std::chrono::steady_clock::now();
+    auto lap_start = frame_start;
+    auto lap = [&](FramePhase phase) {
+        auto now = std::chrono::steady_clock::now();
+        frame_times[phase] +=
+            std::chrono::duration<double, std::milli>(now - lap_start).count();
+        frame_times[FRAME_PHASE_TOTAL] =
+            std::chrono::duration<double, std::milli>(now - frame_start)
+                .count();
+        lap_start = now;
+    };
 
-    uint32_t image_index;
-    auto result =
-        vkAcquireNextImageKHR(device, swapchain, UINT64_MAX,
-                              image_available_semaphores[current_frame],
-                              VK_NULL_HANDLE, &image_index);
+    // the frame that last used this slot was submitted frames_in_flight ago
+    if (frame_count >= frames_in_flight) {
+        wait_for_frame(frame_count + 1 - frames_in_flight);
+    }
+    deletion_queue.collect(poll_completed_frame());
+    lap(FRAME_PHASE_WAIT);
+    frame_wait_ms += frame_times[FRAME_PHASE_WAIT];
+
+    // headless: one offscreen target per frame slot, free once waited on
+    uint32_t image_index = current_frame;
+    auto result = VK_SUCCESS;
+    if (!options.headless) {
+        result = vkAcquireNextImageKHR(
+            device, swapchain, UINT64_MAX,
+            image_available_semaphores[current_frame], VK_NULL_HANDLE,
+            &image_index);
+    }
+    lap(FRAME_PHASE_ACQUIRE);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         framebuffer_resized = false;
@@ -1052,37 +2069,70 @@ void VulkanApplication::draw_frame() {
     } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("failed to acquire swap chain image!");
     }
-    vkResetFences(device, 1,
-                  &in_flight_fences[current_frame]);  // clear immediately
 
+    // swap the placeholder for the streamed texture once it is resident
+    texture_streamer.update();
+    bind_texture(current_frame);
+    collect_cull_counts(current_frame);
     update_uniform_buffer(current_frame);
+    lap(FRAME_PHASE_UPDATE);
 
-    vkResetCommandBuffer(command_buffers[current_frame], 0);
+    vkResetCommandPool(device, frame_command_pools[current_frame], 0);
     record_command_buffer(command_buffers[current_frame], image_index);
+    lap(FRAME_PHASE_RECORD);
 
+    // the GPU waits for the upload batch itself, the host never blocks on it
     VkSemaphore wait_semaphores[] = {
-        image_available_semaphores[current_frame]};  // GPU waits for these
-                                                     // semaphores
-    VkSemaphore signal_semaphores[] = {
-        render_finished_semaphores[current_frame]};  // GPU sets these
-                                                     // semaphores
+        options.headless ? VK_NULL_HANDLE
+                         : image_available_semaphores[current_frame],
+        staging_uploader.timeline_semaphore()};  // GPU waits for these
+                                                 // semaphores
+    uint64_t wait_values[] = {0, upload_ticket};  // binary ones ignore it
+    VkPipelineStageFlags upload_stages =
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    if (options.gpu_culling) {
+        // the culling pass reads the uploaded commands and spheres
+        upload_stages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
     VkPipelineStageFlags wait_stages[] = {
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, upload_stages};
+    VkSemaphore signal_semaphores[] = {
+        options.headless ? VK_NULL_HANDLE
+                         : render_finished_semaphores[image_index],  // GPU
+        frame_timeline};  // sets these semaphores
+    uint64_t signal_values[] = {0, frame_count + 1};
+    // headless has no acquire/present, skip the binary semaphores (first)
+    uint32_t skip = options.headless ? 1 : 0;
+
+    VkTimelineSemaphoreSubmitInfo timeline_info{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount = 2 - skip,
+        .pWaitSemaphoreValues = wait_values + skip,
+        .signalSemaphoreValueCount = 2 - skip,
+        .pSignalSemaphoreValues = signal_values + skip};
     VkSubmitInfo submit_info{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                             .waitSemaphoreCount = 1,
-                             .pWaitSemaphores = wait_semaphores,
-                             .pWaitDstStageMask = wait_stages,
+                             .pNext = &timeline_info,
+                             .waitSemaphoreCount = 2 - skip,
+                             .pWaitSemaphores = wait_semaphores + skip,
+                             .pWaitDstStageMask = wait_stages + skip,
                              .commandBufferCount = 1,
                              .pCommandBuffers = &command_buffers[current_frame],
-                             .signalSemaphoreCount = 1,
-                             .pSignalSemaphores = signal_semaphores};
+                             .signalSemaphoreCount = 2 - skip,
+                             .pSignalSemaphores = signal_semaphores + skip};
 
-    // signal in_flight_fence when cmd buffer exec finished
-    if (vkQueueSubmit(graphics_queue, 1, &submit_info,
-                      in_flight_fences[current_frame]) != VK_SUCCESS) {
+    // frame_timeline reaches frame_count once the cmd buffer exec finished
+    if (vkQueueSubmit(graphics_queue, 1, &submit_info, VK_NULL_HANDLE) !=
+        VK_SUCCESS) {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
+    ++frame_count;
+    lap(FRAME_PHASE_SUBMIT);
+    if (options.headless) {
+        current_frame = (current_frame + 1) % frames_in_flight;
+        return;
+    }
     // Presentation to screen
 
     VkSwapchainKHR swapchains[] = {swapchain};
@@ -1097,6 +2147,7 @@ void VulkanApplication::draw_frame() {
 
     // send image to the swapchain
     result = vkQueuePresentKHR(present_queue, &present_info);
+    lap(FRAME_PHASE_PRESENT);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
         framebuffer_resized) {
         std::cout << "framebuffer need resized!\n";
@@ -1106,85 +2157,113 @@ void VulkanApplication::draw_frame() {
         throw std::runtime_error("failed to present swap chain image!");
     }
 
-    current_frame = (current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+    current_frame = (current_frame + 1) % frames_in_flight;
 }
 
 void VulkanApplication::cleanup() {
+    CPU_ZONE_FUNCTION();
     if (is_initialized) {
+        deletion_queue.flush();
         cleanup_swapchain();
+        cleanup_pipeline();
+
+        allocator.print_stats(std::cout);
+        deletion_queue.print_stats(std::cout);
+        one_time_commands.print_stats(std::cout);
+        texture_streamer.print_stats(std::cout);
+        meshes.print_stats(std::cout);
 
         vkDestroySampler(device, texture_sampler, nullptr);
         vkDestroyImageView(device, texture_image_view, nullptr);
-        vkDestroyImage(device, texture_image, nullptr);
-        vkFreeMemory(device, texture_image_memory, nullptr);
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-            vkDestroyBuffer(device, uniform_buffers[i], nullptr);
-            vkFreeMemory(device, uniform_buffers_memory[i], nullptr);
-        }
+        destroy_image(texture_image, texture_image_allocation);
+        texture_streamer.destroy();
+        asset_pack.close();
+        destroy_buffer(uniform_buffer, uniform_buffer_allocation);
+        destroy_buffer(instance_buffer, instance_buffer_allocation);
+        destroy_buffer(indirect_buffer, indirect_buffer_allocation);
+        destroy_buffer(indirect_count_buffer,
+                       indirect_count_buffer_allocation);
+        destroy_buffer(cull_sphere_buffer, cull_sphere_buffer_allocation);
+        destroy_buffer(visible_buffer, visible_buffer_allocation);
+        destroy_buffer(cull_count_buffer, cull_count_buffer_allocation);
+        vkDestroyDescriptorPool(device, cull_descriptor_pool, nullptr);
+        vkDestroyPipeline(device, cull_pipeline, nullptr);
+        vkDestroyPipelineLayout(device, cull_pipeline_layout, nullptr);
+        vkDestroyDescriptorSetLayout(device, cull_set_layout, nullptr);
         vkDestroyDescriptorPool(device, descriptor_pool, nullptr);
         vkDestroyDescriptorSetLayout(device, descriptor_set_layout, nullptr);
-        vkDestroyBuffer(device, index_buffer, nullptr);
-        vkFreeMemory(device, index_buffer_memory, nullptr);
-        vkDestroyBuffer(device, vertex_buffer, nullptr);
-        vkFreeMemory(device, vertex_buffer_memory, nullptr);
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-            vkDestroySemaphore(device, image_available_semaphores[i], nullptr);
-            vkDestroySemaphore(device, render_finished_semaphores[i], nullptr);
-            vkDestroyFence(device, in_flight_fences[i], nullptr);
+        destroy_buffer(index_buffer, index_buffer_allocation);
+        destroy_buffer(vertex_buffer, vertex_buffer_allocation);
+        for (auto semaphore : image_available_semaphores) {
+            vkDestroySemaphore(device, semaphore, nullptr);
         }
+        for (auto semaphore : render_finished_semaphores) {
+            vkDestroySemaphore(device, semaphore, nullptr);
+        }
+        vkDestroySemaphore(device, frame_timeline, nullptr);
 
-        vkDestroyCommandPool(device, command_pool, nullptr);
-        vkDestroyCommandPool(device, transfer_command_pool, nullptr);
+        record_workers.destroy();
+        for (auto pool : secondary_command_pools) {
+            vkDestroyCommandPool(device, pool, nullptr);
+        }
+        for (auto pool : frame_command_pools) {
+            vkDestroyCommandPool(device, pool, nullptr);
+        }
+        one_time_commands.destroy();
+        staging_uploader.destroy();
+        // the device is idle, every outstanding zone can be read back
+        frame_profiler.resolve_all();
+        upload_profiler.resolve_all();
+        frame_profiler.print_summary(std::cout);
+        upload_profiler.print_summary(std::cout);
+        if (!options.gpu_trace_path.empty()) {
+            try {
+                GpuProfiler::write_chrome_trace(
+                    options.gpu_trace_path,
+                    {&frame_profiler, &upload_profiler});
+                std::cout << "gpu trace written to " << options.gpu_trace_path
+                          << '\n';
+            } catch (std::exception const &e) {
+                std::cerr << e.what() << '\n';
+            }
+        }
+        frame_profiler.destroy();
+        upload_profiler.destroy();
+        pipeline_cache.save();
+        pipeline_cache.destroy();
+        allocator.destroy();
         vkDestroyDevice(device, nullptr);
         if (enable_validation_layers) {
             DestroyDebugUtilsMessengerEXT(instance, debug_messenger, nullptr);
         }
-        vkDestroySurfaceKHR(instance, surface, nullptr);
+        if (!options.headless) {
+            vkDestroySurfaceKHR(instance, surface, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
-        SDL_DestroyWindow(window);
-        SDL_Quit();
+        if (!options.headless) {
+            SDL_DestroyWindow(window);
+            SDL_Quit();
+        }
     }
 }
 
 uint32_t VulkanApplication::find_memory_type(uint32_t type_filter,
                                              VkMemoryPropertyFlags properties) {
-    VkPhysicalDeviceMemoryProperties mem_properties;
-    vkGetPhysicalDeviceMemoryProperties(physical_device, &mem_properties);
-    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-        if (((type_filter >> i) & 1) &&
-            (mem_properties.memoryTypes[i].propertyFlags & properties) ==
-                properties) {
-            return i;
-        }
-    }
-    throw std::runtime_error("failed to find suitable memory type!");
+    // the allocator caches the memory properties queried at device creation
+    return allocator.find_memory_type(type_filter, properties);
 }
 
 void VulkanApplication::create_buffer(VkDeviceSize size,
                                       VkBufferUsageFlags usage,
                                       VkMemoryPropertyFlags properties,
                                       VkBuffer &buffer,
-                                      VkDeviceMemory &buffer_memory) {
-    auto queue_indices = find_queue_families(physical_device);
-    std::vector<uint32_t> indices;
-    if (queue_indices.graphics_family.value() ==
-        queue_indices.transfer_family.value()) {
-        indices.push_back(queue_indices.graphics_family.value());
-    } else {
-        indices.push_back(queue_indices.graphics_family.value());
-        indices.push_back(queue_indices.transfer_family.value());
-    }
-
+                                      Allocation &buffer_allocation) {
+    // uploads and frames share the graphics family, see find_queue_families
     VkBufferCreateInfo buffer_info{
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         .size = size,
         .usage = usage,
-        .sharingMode = (uint32_t)indices.size() == 1
-                           ? VK_SHARING_MODE_EXCLUSIVE
-                           : VK_SHARING_MODE_CONCURRENT,
-        // create buffer which queues included
-        .queueFamilyIndexCount = (uint32_t)indices.size(),
-        .pQueueFamilyIndices = indices.data()};
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE};
 
     if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to create vertex buffer!");
@@ -1193,91 +2272,65 @@ void VulkanApplication::create_buffer(VkDeviceSize size,
     VkMemoryRequirements mem_requirements;
     vkGetBufferMemoryRequirements(device, buffer, &mem_requirements);
 
-    // GPU memory alloc
-    VkMemoryAllocateInfo alloc_info{
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = mem_requirements.size,
-        // enable write from CPU && CPU/GPU memory strictly coherent
-        .memoryTypeIndex =
-            find_memory_type(mem_requirements.memoryTypeBits, properties)};
-
-    if (vkAllocateMemory(device, &alloc_info, nullptr, &buffer_memory) !=
-        VK_SUCCESS) {
-        throw std::runtime_error(
-            "failed to allocate vertex buffer on GPU memory!");
-    }
+    // GPU memory alloc: sub-allocated from a shared block of that memory type
+    buffer_allocation = allocator.allocate(
+        mem_requirements,
+        find_memory_type(mem_requirements.memoryTypeBits, properties), true);
 
     // bind CPU & GPU memories
-    vkBindBufferMemory(device, buffer, buffer_memory, 0);
+    vkBindBufferMemory(device, buffer, buffer_allocation.memory,
+                       buffer_allocation.offset);
 }
 
-void VulkanApplication::copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer,
-                                    VkDeviceSize size) {
-    auto cmd_buf = begin_single_commands(transfer_command_pool);
-
-    VkBufferCopy copy_region{.srcOffset = 0, .dstOffset = 0, .size = size};
-    vkCmdCopyBuffer(cmd_buf, src_buffer, dst_buffer, 1, &copy_region);
-
-    end_single_commands(cmd_buf, transfer_command_pool);
+void VulkanApplication::destroy_buffer(VkBuffer &buffer,
+                                       Allocation &buffer_allocation) {
+    vkDestroyBuffer(device, buffer, nullptr);
+    allocator.free(buffer_allocation);
+    buffer = VK_NULL_HANDLE;
 }
 
-void VulkanApplication::create_vertex_buffer() {
-    VkDeviceSize buffer_size = sizeof(vertices[0]) * vertices.size();
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-
-    create_buffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                  staging_buffer, staging_buffer_memory);
-    // copy buffer memory from cpu to gpu
-    void *data;
-    vkMapMemory(device, staging_buffer_memory, 0, buffer_size, 0, &data);
-    memcpy(data, vertices.data(), (size_t)buffer_size);
-    vkUnmapMemory(device, staging_buffer_memory);
+// the quad is always mesh 0, every --mesh follows in order
+void VulkanApplication::load_meshes() {
+    CPU_ZONE_FUNCTION();
+    auto quad = asset_pack.mesh(MESH_ASSET);
+    if (quad.vertices) {
+        meshes.add_packed(MESH_ASSET, quad);
+    } else {
+        meshes.add(MESH_ASSET, vertices.data(), (uint32_t)vertices.size(),
+                   indices.data(), (uint32_t)indices.size());
+    }
+    for (auto const &path : options.mesh_paths) {
+        auto packed = asset_pack.mesh(path);
+        if (packed.vertices) {
+            meshes.add_packed(path, packed);
+        } else {
+            meshes.load_obj(path);
+        }
+    }
+}
 
+void VulkanApplication::create_mesh_buffers() {
+    CPU_ZONE_FUNCTION();
     create_buffer(
-        buffer_size,
+        meshes.vertex_bytes(),
         // final vertex buffer: transfer_dst & vertex_buffer
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertex_buffer,
-        vertex_buffer_memory);
-    copy_buffer(staging_buffer, vertex_buffer, buffer_size);
-
-    // destroy buffers explicitly
-    vkDestroyBuffer(device, staging_buffer, nullptr);
-    vkFreeMemory(device, staging_buffer_memory, nullptr);
-}
-void VulkanApplication::create_index_buffer() {
-    VkDeviceSize buffer_size = sizeof(indices[0]) * indices.size();
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-
-    create_buffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                  staging_buffer, staging_buffer_memory);
-    // copy buffer memory from cpu to gpu
-    void *data;
-    vkMapMemory(device, staging_buffer_memory, 0, buffer_size, 0, &data);
-    memcpy(data, indices.data(), (size_t)buffer_size);
-    vkUnmapMemory(device, staging_buffer_memory);
-
+        vertex_buffer_allocation);
     create_buffer(
-        buffer_size,
-        // final vertex buffer: transfer_dst & index_buffer
+        meshes.index_bytes(),
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, index_buffer, index_buffer_memory);
-    copy_buffer(staging_buffer, index_buffer, buffer_size);
-
-    // destroy buffers explicitly
-    vkDestroyBuffer(device, staging_buffer, nullptr);
-    vkFreeMemory(device, staging_buffer_memory, nullptr);
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, index_buffer,
+        index_buffer_allocation);
+    // copy from cpu to gpu through the staging ring, submitted in a batch
+    meshes.upload(staging_uploader, vertex_buffer, index_buffer);
 }
+
 void VulkanApplication::create_descriptor_set_layout() {
+    CPU_ZONE_FUNCTION();
     VkDescriptorSetLayoutBinding ubo_layout_binding{
         .binding = 0,
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
         .descriptorCount = 1,  // could be uniform array
         .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
         .pImmutableSamplers =
@@ -1291,8 +2344,16 @@ void VulkanApplication::create_descriptor_set_layout() {
         .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
         .pImmutableSamplers = nullptr};
 
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {
+    std::vector<VkDescriptorSetLayoutBinding> bindings = {
         ubo_layout_binding, sampler_layout_binding};
+    // indirect mode reads the per-object transforms from a storage buffer
+    if (options.render_mode == RENDER_MODE_INDIRECT) {
+        bindings.push_back({.binding = 2,
+                            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                            .descriptorCount = 1,
+                            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                            .pImmutableSamplers = nullptr});
+    }
 
     VkDescriptorSetLayoutCreateInfo layout_info{
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
@@ -1305,19 +2366,276 @@ void VulkanApplication::create_descriptor_set_layout() {
     }
 }
 void VulkanApplication::create_uniform_buffers() {
-    VkDeviceSize buffer_size = sizeof(UniformBufferObject);
+    CPU_ZONE_FUNCTION();
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    // dynamic offsets must be multiples of minUniformBufferOffsetAlignment
+    auto alignment = properties.limits.minUniformBufferOffsetAlignment;
+    uniform_stride = (sizeof(UniformBufferObject) + alignment - 1) /
+                     alignment * alignment;
+    // a frame only writes view and projection, model matrices travel per
+    // instance or as push constants
+    VkDeviceSize buffer_size = uniform_stride * frames_in_flight;
 
-    uniform_buffers.resize(MAX_FRAMES_IN_FLIGHT);
-    uniform_buffers_memory.resize(MAX_FRAMES_IN_FLIGHT);
+    create_buffer(buffer_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  uniform_buffer, uniform_buffer_allocation);
+    // mapped once here, every update afterwards is a plain memcpy
+    uniform_mapped = static_cast<char *>(uniform_buffer_allocation.mapped);
+}
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-        create_buffer(buffer_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                      uniform_buffers[i], uniform_buffers_memory[i]);
+void VulkanApplication::create_instance_buffer() {
+    CPU_ZONE_FUNCTION();
+    if (options.render_mode == RENDER_MODE_PER_OBJECT) {
+        return;
     }
+    // storage buffer descriptors need their offset aligned, vertex
+    // bindings do not care
+    VkDeviceSize alignment = 1;
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    if (options.render_mode == RENDER_MODE_INDIRECT) {
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(physical_device, &properties);
+        alignment = properties.limits.minStorageBufferOffsetAlignment;
+        usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    }
+    instance_slice = (sizeof(InstanceData) * scene_objects.size() +
+                      alignment - 1) /
+                     alignment * alignment;
+    // rewritten in bulk every frame, so it stays host visible instead of
+    // going through the staging uploader
+    create_buffer(instance_slice * frames_in_flight, usage,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  instance_buffer, instance_buffer_allocation);
+    instance_mapped = static_cast<char *>(instance_buffer_allocation.mapped);
 }
+
+// static for now: the scene never changes, only the transforms the
+// commands point at through firstInstance
+void VulkanApplication::create_indirect_buffers() {
+    CPU_ZONE_FUNCTION();
+    if (options.render_mode != RENDER_MODE_INDIRECT) {
+        return;
+    }
+    // firstInstance is how a command finds its object
+    if (!draw_indirect_first_instance) {
+        throw std::runtime_error(
+            "indirect rendering needs drawIndirectFirstInstance!");
+    }
+    // instance batches are ordered by index type, so each index type is
+    // one contiguous range of commands
+    std::vector<VkDrawIndexedIndirectCommand> commands;
+    commands.reserve(scene_objects.size());
+    indirect_batches.clear();
+    for (auto const &batch : instance_batches) {
+        auto const &mesh = meshes.mesh(batch.mesh);
+        if (indirect_batches.empty() ||
+            indirect_batches.back().index_type != mesh.index_type) {
+            indirect_batches.push_back(
+                {.index_type = mesh.index_type,
+                 .first_command = (uint32_t)commands.size(),
+                 .command_count = 0});
+        }
+        for (uint32_t i = 0; i < batch.instance_count; ++i) {
+            commands.push_back({.indexCount = mesh.index_count,
+                                .instanceCount = 1,
+                                .firstIndex = mesh.first_index,
+                                .vertexOffset = mesh.vertex_offset,
+                                .firstInstance = batch.first_instance + i});
+        }
+        indirect_batches.back().command_count += batch.instance_count;
+    }
+    std::vector<uint32_t> counts;
+    indirect_count_draws = draw_indirect_count;
+    for (auto const &batch : indirect_batches) {
+        counts.push_back(batch.command_count);
+        indirect_count_draws = indirect_count_draws &&
+                               batch.command_count <= max_draw_indirect_count;
+    }
+    draws_per_frame = 0;
+    for (auto const &batch : indirect_batches) {
+        draws_per_frame += indirect_count_draws
+                               ? 1
+                               : (batch.command_count +
+                                  max_draw_indirect_count - 1) /
+                                     max_draw_indirect_count;
+    }
+
+    VkDeviceSize commands_size =
+        commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+    // the culling pass reads the commands as a storage buffer
+    create_buffer(commands_size,
+                  VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indirect_buffer,
+                  indirect_buffer_allocation);
+    staging_uploader.upload_buffer(indirect_buffer, 0, commands.data(),
+                                   commands_size);
+    VkDeviceSize counts_size = counts.size() * sizeof(uint32_t);
+    create_buffer(
+        counts_size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indirect_count_buffer,
+        indirect_count_buffer_allocation);
+    staging_uploader.upload_buffer(indirect_count_buffer, 0, counts.data(),
+                                   counts_size);
+}
+
+void VulkanApplication::create_cull_buffers() {
+    CPU_ZONE_FUNCTION();
+    if (!options.gpu_culling) {
+        return;
+    }
+    // commands are laid out like the instances, so command i culls with
+    // the bounding sphere of the mesh of instance i
+    std::vector<Eigen::Vector4f> spheres(scene_objects.size());
+    for (auto const &batch : instance_batches) {
+        auto const &bounds = meshes.mesh(batch.mesh).bounds;
+        std::fill_n(spheres.begin() + batch.first_instance,
+                    batch.instance_count,
+                    Eigen::Vector4f(bounds[0], bounds[1], bounds[2],
+                                    bounds[3]));
+    }
+    VkDeviceSize spheres_size = spheres.size() * sizeof(Eigen::Vector4f);
+    create_buffer(
+        spheres_size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, cull_sphere_buffer,
+        cull_sphere_buffer_allocation);
+    staging_uploader.upload_buffer(cull_sphere_buffer, 0, spheres.data(),
+                                   spheres_size);
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    auto alignment = properties.limits.minStorageBufferOffsetAlignment;
+    auto align = [&](VkDeviceSize size) {
+        return (size + alignment - 1) / alignment * alignment;
+    };
+    visible_slice =
+        align(scene_objects.size() * sizeof(VkDrawIndexedIndirectCommand));
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                               VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    create_buffer(visible_slice * frames_in_flight, usage,
+                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, visible_buffer,
+                  visible_buffer_allocation);
+    // two batch counts and the visible triangles
+    cull_count_slice = align(4 * sizeof(uint32_t));
+    create_buffer(cull_count_slice * frames_in_flight, usage,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  cull_count_buffer, cull_count_buffer_allocation);
+    cull_count_mapped =
+        static_cast<char *>(cull_count_buffer_allocation.mapped);
+    memset(cull_count_mapped, 0, cull_count_slice * frames_in_flight);
+
+    cull_params.command_count = (uint32_t)scene_objects.size();
+    cull_params.batch_split = indirect_batches.size() > 1
+                                  ? indirect_batches[1].first_command
+                                  : UINT32_MAX;
+    cull_params.compact = indirect_count_draws ? 1 : 0;
+}
+
+void VulkanApplication::create_cull_descriptor_sets() {
+    CPU_ZONE_FUNCTION();
+    if (!options.gpu_culling) {
+        return;
+    }
+    VkDescriptorPoolSize pool_size{
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 5 * frames_in_flight};
+    VkDescriptorPoolCreateInfo pool_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = frames_in_flight,
+        .poolSizeCount = 1,
+        .pPoolSizes = &pool_size};
+    if (vkCreateDescriptorPool(device, &pool_info, nullptr,
+                               &cull_descriptor_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create cull descriptor pool!");
+    }
+
+    std::vector<VkDescriptorSetLayout> layouts(frames_in_flight,
+                                               cull_set_layout);
+    VkDescriptorSetAllocateInfo alloc_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = cull_descriptor_pool,
+        .descriptorSetCount = frames_in_flight,
+        .pSetLayouts = layouts.data()};
+    cull_descriptor_sets.resize(frames_in_flight);
+    if (vkAllocateDescriptorSets(device, &alloc_info,
+                                 cull_descriptor_sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate cull descriptor sets!");
+    }
+
+    VkDeviceSize commands_size =
+        scene_objects.size() * sizeof(VkDrawIndexedIndirectCommand);
+    for (uint32_t i = 0; i < frames_in_flight; ++i) {
+        // same binding order as cull.comp
+        std::array<VkDescriptorBufferInfo, 5> buffer_infos{
+            VkDescriptorBufferInfo{.buffer = instance_buffer,
+                                   .offset = i * instance_slice,
+                                   .range = instance_slice},
+            VkDescriptorBufferInfo{.buffer = indirect_buffer,
+                                   .offset = 0,
+                                   .range = commands_size},
+            VkDescriptorBufferInfo{.buffer = cull_sphere_buffer,
+                                   .offset = 0,
+                                   .range = VK_WHOLE_SIZE},
+            VkDescriptorBufferInfo{.buffer = visible_buffer,
+                                   .offset = i * visible_slice,
+                                   .range = visible_slice},
+            VkDescriptorBufferInfo{.buffer = cull_count_buffer,
+                                   .offset = i * cull_count_slice,
+                                   .range = cull_count_slice}};
+        std::array<VkWriteDescriptorSet, 5> descriptor_writes{};
+        for (uint32_t binding = 0; binding < buffer_infos.size(); ++binding) {
+            descriptor_writes[binding] = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = cull_descriptor_sets[i],
+                .dstBinding = binding,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &buffer_infos[binding]};
+        }
+        vkUpdateDescriptorSets(device, (uint32_t)descriptor_writes.size(),
+                               descriptor_writes.data(), 0, nullptr);
+    }
+}
+
+// the slot's previous frame has finished: fold its counts into the stats
+// and zero them for the frame about to be recorded
+void VulkanApplication::collect_cull_counts(uint32_t slot) {
+    if (!options.gpu_culling) {
+        return;
+    }
+    auto *counts = reinterpret_cast<uint32_t *>(cull_count_mapped +
+                                                slot * cull_count_slice);
+    if (frame_count >= frames_in_flight) {
+        cull_stats.frames += 1;
+        cull_stats.visible_objects += counts[0] + counts[1];
+        cull_stats.visible_triangles += counts[2];
+    }
+    memset(counts, 0, 4 * sizeof(uint32_t));
+}
+
+// cheap per-instance variation, cycles through a few hues; shader.vert
+// holds the same palette and looks it up by material
+static uint32_t object_material(size_t index) { return index % 4; }
+
+static Eigen::Vector4f object_tint(size_t index) {
+    static const Eigen::Vector4f palette[] = {{1.0f, 1.0f, 1.0f, 1.0f},
+                                              {1.0f, 0.6f, 0.6f, 1.0f},
+                                              {0.6f, 1.0f, 0.6f, 1.0f},
+                                              {0.6f, 0.6f, 1.0f, 1.0f}};
+    return palette[object_material(index)];
+}
+
 void VulkanApplication::update_uniform_buffer(uint32_t current_image) {
+    CPU_ZONE_FUNCTION();
     static auto start_time = std::chrono::high_resolution_clock::now();
     auto current_time = std::chrono::high_resolution_clock::now();
     float time = std::chrono::duration<float, std::chrono::seconds::period>(
@@ -1327,8 +2645,6 @@ void VulkanApplication::update_uniform_buffer(uint32_t current_image) {
     using namespace Eigen;
     using namespace EigenHelper;
 
-    Eigen::Matrix4f model = EigenHelper::rotate(
-        time * 90.0f / 180.0f * 3.1415926, Eigen::Vector3f::UnitZ());
     Eigen::Matrix4f view = EigenHelper::lookAt(
         Eigen::Vector3f(2.0f, 2.0f, 2.0f), Eigen::Vector3f(0.0f, 0.0f, 0.0f),
         Eigen::Vector3f(0.0f, 0.0f, 1.0f));
@@ -1336,28 +2652,160 @@ void VulkanApplication::update_uniform_buffer(uint32_t current_image) {
         45.0f / 180.0f * 3.1415926,
         swapchain_extent.width / (float)swapchain_extent.height, 0.1, 10.f);
 
-    UniformBufferObject ubo{.model = model, .view = view, .project = project};
-    ubo.project(1, 1) *= -1;
+    project(1, 1) *= -1;
+    if (options.gpu_culling) {
+        auto planes = EigenHelper::frustum_planes(project * view);
+        std::copy(planes.begin(), planes.end(), cull_params.planes);
+    }
+    if (options.cpu_culling) {
+        // the record workers are idle until this frame gets recorded
+        auto cull_start = std::chrono::steady_clock::now();
+        cpu_culler.cull(EigenHelper::frustum_planes(project * view),
+                        draw_objects, &record_workers);
+        cull_time_ms += std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - cull_start)
+                            .count();
+        cull_stats.frames += 1;
+        cull_stats.visible_objects += draw_objects.size();
+        for (auto index : draw_objects) {
+            cull_stats.visible_triangles +=
+                meshes.mesh(scene_objects[index].mesh).index_count / 3;
+        }
+    }
 
-    void *data;
-    vkMapMemory(device, uniform_buffers_memory[current_image], 0, sizeof(ubo),
-                0, &data);
-    memcpy(data, &ubo, sizeof(ubo));
-    vkUnmapMemory(device, uniform_buffers_memory[current_image]);
+    // the slot of this frame is free again once its fence has signaled
+    UniformBufferObject ubo{.view = view, .project = project};
+    uniform_offset = (uint32_t)(current_image * uniform_stride);
+    memcpy(uniform_mapped + uniform_offset, &ubo, sizeof(ubo));
+    draw_constants.clear();
+    bool instanced = options.render_mode != RENDER_MODE_PER_OBJECT;
+    auto *instances =
+        instanced ? reinterpret_cast<InstanceData *>(
+                        instance_mapped + current_image * instance_slice)
+                  : nullptr;
+    // every object unless cpu culling dropped some of them
+    for (auto i : draw_objects) {
+        auto const &object = scene_objects[i];
+        Eigen::Matrix4f model =
+            EigenHelper::translate(object.position.x(), object.position.y(),
+                                   object.position.z()) *
+            EigenHelper::rotate(time * object.spin / 180.0f * 3.1415926,
+                                Eigen::Vector3f::UnitZ()) *
+            Eigen::Affine3f(Eigen::Scaling(object.scale)).matrix() *
+            EigenHelper::translate(-object.pivot.x(), -object.pivot.y(),
+                                   -object.pivot.z());
+        if (instanced) {
+            // written straight into mapped memory, batches stay contiguous
+            auto &instance = instances[instance_slots[i]];
+            instance.model = model;
+            instance.tint = object_tint(i);
+            continue;
+        }
+        draw_constants.push_back(
+            {.model = model, .material = object_material(i)});
+    }
+}
+
+// lays the objects out on a square grid in the z = 0 plane, scaled so the
+// whole grid covers the area the single quad used to
+void VulkanApplication::create_scene() {
+    CPU_ZONE_FUNCTION();
+    auto count = std::max(options.object_count, 1u);
+    auto side = (uint32_t)std::ceil(std::sqrt((double)count));
+    float cell = 1.0f / (float)side;
+    // spreading moves the objects apart without growing them
+    float spread = options.scene_spread;
+    scene_objects.clear();
+    scene_objects.reserve(count);
+    triangles_per_frame = 0;
+    // loaded meshes replace the quad and are scaled to its bounding sphere
+    auto first_mesh = meshes.size() > 1 ? 1u : 0u;
+    auto quad_radius = meshes.mesh(0).bounds[3];
+    for (uint32_t i = 0; i < count; ++i) {
+        float x = (((float)(i % side) + 0.5f) * cell - 0.5f) * spread;
+        float y = (((float)(i / side) + 0.5f) * cell - 0.5f) * spread;
+        auto mesh_id = first_mesh + i % (meshes.size() - first_mesh);
+        auto const &mesh = meshes.mesh(mesh_id);
+        scene_objects.push_back(
+            {.mesh = mesh_id,
+             .pivot = Eigen::Vector3f(mesh.bounds[0], mesh.bounds[1],
+                                      mesh.bounds[2]),
+             .position = side == 1 ? Eigen::Vector3f::Zero()
+                                   : Eigen::Vector3f(2.0f * x, 2.0f * y, 0.0f),
+             .scale = 2.0f * cell * quad_radius /
+                      std::max(mesh.bounds[3], 1e-6f),
+             .spin = 90.0f * (1.0f + (float)(i % 7) * 0.25f)});
+        triangles_per_frame += mesh.index_count / 3;
+    }
+    draws_per_frame = count;
+    draw_objects.resize(count);
+    std::iota(draw_objects.begin(), draw_objects.end(), 0u);
+    if (options.cpu_culling) {
+        // the model matrix takes the pivot to position, spinning about z
+        // keeps the scaled bounding sphere where it is
+        cpu_culler.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            auto const &object = scene_objects[i];
+            cpu_culler.set_sphere(
+                i, object.position,
+                meshes.mesh(object.mesh).bounds[3] * object.scale);
+        }
+    }
+
+    // instanced mode draws each mesh once, so the instances of a mesh are
+    // packed together: count per mesh, prefix sum, then hand out slots
+    instance_batches.clear();
+    instance_slots.clear();
+    if (options.render_mode == RENDER_MODE_PER_OBJECT) {
+        return;
+    }
+    std::vector<uint32_t> first_slot(meshes.size(), 0);
+    for (auto const &object : scene_objects) {
+        ++first_slot[object.mesh];
+    }
+    // 16 bit meshes first, indirect draws need one range per index type
+    std::vector<uint32_t> mesh_order(meshes.size());
+    std::iota(mesh_order.begin(), mesh_order.end(), 0u);
+    std::stable_sort(mesh_order.begin(), mesh_order.end(),
+                     [&](uint32_t a, uint32_t b) {
+                         return meshes.mesh(a).index_type <
+                                meshes.mesh(b).index_type;
+                     });
+    uint32_t next = 0;
+    for (auto mesh_id : mesh_order) {
+        auto instance_count = first_slot[mesh_id];
+        first_slot[mesh_id] = next;
+        if (instance_count > 0) {
+            instance_batches.push_back({.mesh = mesh_id,
+                                        .first_instance = next,
+                                        .instance_count = instance_count});
+        }
+        next += instance_count;
+    }
+    instance_slots.reserve(count);
+    for (auto const &object : scene_objects) {
+        instance_slots.push_back(first_slot[object.mesh]++);
+    }
+    draws_per_frame = (uint32_t)instance_batches.size();
 }
 
 void VulkanApplication::create_descriptor_pool() {
-    std::array<VkDescriptorPoolSize, 2> pool_sizes{
-        VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                             .descriptorCount = (uint32_t)MAX_FRAMES_IN_FLIGHT},
+    CPU_ZONE_FUNCTION();
+    std::vector<VkDescriptorPoolSize> pool_sizes{
+        VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                             .descriptorCount = frames_in_flight},
         VkDescriptorPoolSize{
             .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-            .descriptorCount = (uint32_t)MAX_FRAMES_IN_FLIGHT}};
+            .descriptorCount = frames_in_flight}};
+    if (options.render_mode == RENDER_MODE_INDIRECT) {
+        pool_sizes.push_back({.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                              .descriptorCount = frames_in_flight});
+    }
 
     VkDescriptorPoolCreateInfo pool_info{
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        .maxSets = (uint32_t)MAX_FRAMES_IN_FLIGHT,  // descriptor set max size
-        .poolSizeCount = 2,
+        .maxSets = frames_in_flight,  // descriptor set max size
+        .poolSizeCount = (uint32_t)pool_sizes.size(),
         .pPoolSizes = pool_sizes.data(),
     };
 
@@ -1368,24 +2816,25 @@ void VulkanApplication::create_descriptor_pool() {
 }
 
 void VulkanApplication::create_descriptor_sets() {
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT,
+    CPU_ZONE_FUNCTION();
+    std::vector<VkDescriptorSetLayout> layouts(frames_in_flight,
                                                descriptor_set_layout);
     VkDescriptorSetAllocateInfo alloc_info{
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool = descriptor_pool,
-        .descriptorSetCount = (uint32_t)MAX_FRAMES_IN_FLIGHT,
+        .descriptorSetCount = frames_in_flight,
         .pSetLayouts = layouts.data()};
 
-    descriptor_sets.resize(MAX_FRAMES_IN_FLIGHT);
+    descriptor_sets.resize(frames_in_flight);
     if (vkAllocateDescriptorSets(device, &alloc_info, descriptor_sets.data()) !=
         VK_SUCCESS) {
         throw std::runtime_error("failed to allocate descriptor sets!");
     }
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+    for (size_t i = 0; i < frames_in_flight; ++i) {
         VkDescriptorBufferInfo buffer_info{
-            .buffer = uniform_buffers[i],
-            .offset = 0,
+            .buffer = uniform_buffer,
+            .offset = 0,  // the dynamic offset picks the frame's slot
             .range = sizeof(UniformBufferObject)};
         VkDescriptorImageInfo image_info{
             .sampler = texture_sampler,
@@ -1393,14 +2842,14 @@ void VulkanApplication::create_descriptor_sets() {
             .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
         };
 
-        std::array<VkWriteDescriptorSet, 2> descriptor_writes{
+        std::vector<VkWriteDescriptorSet> descriptor_writes{
             VkWriteDescriptorSet{
                 .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
                 .dstSet = descriptor_sets[i],
                 .dstBinding = 0,       // binding location
                 .dstArrayElement = 0,  // first index
                 .descriptorCount = 1,
-                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                 .pImageInfo = nullptr,        // refer to image data
                 .pBufferInfo = &buffer_info,  // refer to buffer data
                 .pTexelBufferView = nullptr   // refer to buffer view
@@ -1416,67 +2865,117 @@ void VulkanApplication::create_descriptor_sets() {
                 .pBufferInfo = nullptr,      // refer to buffer data
                 .pTexelBufferView = nullptr  // refer to buffer view
             }};
+        // each frame slot sees only its own slice of the object buffer
+        VkDescriptorBufferInfo object_info{.buffer = instance_buffer,
+                                           .offset = i * instance_slice,
+                                           .range = instance_slice};
+        if (options.render_mode == RENDER_MODE_INDIRECT) {
+            descriptor_writes.push_back(
+                {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                 .dstSet = descriptor_sets[i],
+                 .dstBinding = 2,
+                 .dstArrayElement = 0,
+                 .descriptorCount = 1,
+                 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                 .pBufferInfo = &object_info});
+        }
         vkUpdateDescriptorSets(device, (uint32_t)descriptor_writes.size(),
                                descriptor_writes.data(), 0, nullptr);
     }
+    bound_texture_views.assign(frames_in_flight, texture_image_view);
 }
+
+// tiny checkerboard, uploaded with the rest of init, shown until the real
+// texture is streamed in
 void VulkanApplication::create_texture_image() {
-    int tex_width, tex_height, tex_channels;
-    stbi_uc *pixels = stbi_load("textures/texture.jpg", &tex_width, &tex_height,
-                                &tex_channels, STBI_rgb_alpha);
-    VkDeviceSize image_size = tex_width * tex_height * 4;  // RGBA
-    if (!pixels) {
-        throw std::runtime_error("failed to load texture image!");
-    }
-
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-    // create staging buffer for copy_buffer2image first
-    create_buffer(image_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                  staging_buffer, staging_buffer_memory);
+    CPU_ZONE_FUNCTION();
+    const uint32_t size = 8;
+    std::vector<uint32_t> pixels(size * size);
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            pixels[y * size + x] = ((x ^ y) & 1) ? 0xff808080 : 0xffc0c0c0;
+        }
+    }
 
-    void *data;
-    vkMapMemory(device, staging_buffer_memory, 0, image_size, 0, &data);
-    memcpy(data, pixels, (size_t)image_size);
-    vkUnmapMemory(device, staging_buffer_memory);
-    stbi_image_free(pixels);
+    // small enough to filter on the CPU whatever the mip mode
+    texture_mip_levels = options.mip_generation == MIP_GENERATION_NONE
+                             ? 1
+                             : mip_level_count(size, size);
+    auto chain = build_mip_chain_rgba8(
+        reinterpret_cast<unsigned char const *>(pixels.data()), size, size,
+        texture_mip_levels, true);
 
-    create_image(tex_width, tex_height, VK_FORMAT_R8G8B8A8_SRGB,
+    create_image(size, size, texture_mip_levels, VK_FORMAT_R8G8B8A8_SRGB,
                  VK_IMAGE_TILING_OPTIMAL,
                  VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture_image,
-                 texture_image_memory);
+                 texture_image_allocation);
+
+    // layout transitions are recorded around the copy in the same batch
+    staging_uploader.upload_image(
+        texture_image, size, size, chain.data(), chain.size(),
+        {.provided = texture_mip_levels, .total = texture_mip_levels});
+}
 
-    // transfer image to target layout first
-    transition_image_layout(texture_image, VK_FORMAT_R8G8B8A8_SRGB,
-                            VK_IMAGE_LAYOUT_UNDEFINED,
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copy_buffer2image(staging_buffer, texture_image, (uint32_t)tex_width,
-                      (uint32_t)tex_height);
+void VulkanApplication::create_texture_streamer() {
+    CPU_ZONE_FUNCTION();
+    auto mip_generation = options.mip_generation;
+    if (mip_generation == MIP_GENERATION_BLIT &&
+        !supports_linear_blit(physical_device, VK_FORMAT_R8G8B8A8_SRGB)) {
+        mip_generation = MIP_GENERATION_CPU;
+    }
+    texture_streamer.init(physical_device, device, &allocator,
+                          &staging_uploader, &one_time_commands,
+                          mip_generation, TEXTURE_DECODE_THREADS);
+    streamed_texture =
+        texture_streamer.request(options.texture_path, &asset_pack);
+}
 
-    transition_image_layout(texture_image, VK_FORMAT_R8G8B8A8_SRGB,
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+// only called for a slot whose previous frame finished, so its descriptor
+// set is not in use and can be rewritten in place
+void VulkanApplication::bind_texture(uint32_t slot) {
+    auto view = texture_streamer.view(streamed_texture);
+    if (view == VK_NULL_HANDLE) {
+        view = texture_image_view;
+    } else {
+        // already signaled, but makes the transfer visible to this queue
+        upload_ticket =
+            std::max(upload_ticket, texture_streamer.ticket(streamed_texture));
+    }
+    if (bound_texture_views[slot] == view) {
+        return;
+    }
 
-    vkDestroyBuffer(device, staging_buffer, nullptr);
-    vkFreeMemory(device, staging_buffer_memory, nullptr);
+    VkDescriptorImageInfo image_info{
+        .sampler = texture_sampler,
+        .imageView = view,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkWriteDescriptorSet descriptor_write{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = descriptor_sets[slot],
+        .dstBinding = 1,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &image_info};
+    vkUpdateDescriptorSets(device, 1, &descriptor_write, 0, nullptr);
+    bound_texture_views[slot] = view;
 }
 
 void VulkanApplication::create_image(uint32_t width, uint32_t height,
-                                     VkFormat format, VkImageTiling tiling,
+                                     uint32_t mip_levels, VkFormat format,
+                                     VkImageTiling tiling,
                                      VkImageUsageFlags usage,
                                      VkMemoryPropertyFlags properties,
                                      VkImage &image,
-                                     VkDeviceMemory &image_memory) {
+                                     Allocation &image_allocation) {
     VkImageCreateInfo image_info{
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .imageType = VK_IMAGE_TYPE_2D,
         .format = format,
         .extent{
             .width = (uint32_t)width, .height = (uint32_t)height, .depth = 1},
-        .mipLevels = 1,
+        .mipLevels = mip_levels,
         .arrayLayers = 1,
         .samples = VK_SAMPLE_COUNT_1_BIT,  // for multi-sampling
         .tiling = tiling,                  // for optimal access
@@ -1492,129 +2991,30 @@ void VulkanApplication::create_image(uint32_t width, uint32_t height,
     VkMemoryRequirements mem_requirements;
     // not vkGetBufferMemoryRequirements
     vkGetImageMemoryRequirements(device, image, &mem_requirements);
-    VkMemoryAllocateInfo alloc_info{
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = mem_requirements.size,
-        .memoryTypeIndex =
-            find_memory_type(mem_requirements.memoryTypeBits, properties)};
-
-    if (vkAllocateMemory(device, &alloc_info, nullptr, &image_memory) !=
-        VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate texture image memory!");
-    }
-    vkBindImageMemory(device, image, image_memory, 0);
-}
-
-VkCommandBuffer VulkanApplication::begin_single_commands(
-    VkCommandPool command_pool) {
-    VkCommandBufferAllocateInfo alloc_info{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool = command_pool,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = 1};
-
-    VkCommandBuffer transfer_command_buffer;
-    vkAllocateCommandBuffers(device, &alloc_info, &transfer_command_buffer);
-    // create transient cmd buffer
-    VkCommandBufferBeginInfo begin_info{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags =
-            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT  // once submit, reset
-    };
-
-    if (vkBeginCommandBuffer(transfer_command_buffer, &begin_info) !=
-        VK_SUCCESS) {
-        throw std::runtime_error("failed to begin transfer command buffer!");
-    }
-    return transfer_command_buffer;
+    image_allocation = allocator.allocate(
+        mem_requirements,
+        find_memory_type(mem_requirements.memoryTypeBits, properties),
+        tiling == VK_IMAGE_TILING_LINEAR);
+    vkBindImageMemory(device, image, image_allocation.memory,
+                      image_allocation.offset);
 }
 
-void VulkanApplication::end_single_commands(VkCommandBuffer command_buffer,
-                                            VkCommandPool command_pool) {
-    vkEndCommandBuffer(command_buffer);  // stop recording
-
-    VkSubmitInfo submit_info{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                             .commandBufferCount = 1,
-                             .pCommandBuffers = &command_buffer};
-
-    vkQueueSubmit(transfer_queue, 1, &submit_info, nullptr);
-    vkQueueWaitIdle(transfer_queue);
-
-    // don't forget to clean cmd buffer
-    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
+void VulkanApplication::destroy_image(VkImage &image,
+                                      Allocation &image_allocation) {
+    vkDestroyImage(device, image, nullptr);
+    allocator.free(image_allocation);
+    image = VK_NULL_HANDLE;
 }
-void VulkanApplication::transition_image_layout(VkImage image, VkFormat format,
-                                                VkImageLayout old_layout,
-                                                VkImageLayout new_layout) {
-    auto command_buffer = begin_single_commands(command_pool);
-
-    VkPipelineStageFlags source_stage, destination_stage;
-
-    VkImageMemoryBarrier barrier{
-        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        // describe operations before or after the barrier
-        .oldLayout = old_layout,
-        .newLayout = new_layout,
-        // set if u don't want queue families ownership transfer
-        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .image = image,
-        .subresourceRange{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                          .baseMipLevel = 0,
-                          .levelCount = 1,
-                          .baseArrayLayer = 0,
-                          .layerCount = 1}};
 
-    // before copy buffer to image, set image layout from UNDEFINED to
-    // TRANSFER_DST
-    if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
-        new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;  // earliest possible
-        destination_stage =
-            VK_PIPELINE_STAGE_TRANSFER_BIT;  // pseudo transfer stage
-    } else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-               new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask =
-            VK_ACCESS_TRANSFER_WRITE_BIT;  // from copy operations
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    }
-
-    vkCmdPipelineBarrier(command_buffer, source_stage, destination_stage, 0, 0,
-                         nullptr, 0, nullptr, 1, &barrier);
-
-    end_single_commands(command_buffer, command_pool);
-}
-void VulkanApplication::copy_buffer2image(VkBuffer buffer, VkImage image,
-                                          uint32_t width, uint32_t height) {
-    VkCommandBuffer command_buffer =
-        begin_single_commands(transfer_command_pool);
-
-    VkBufferImageCopy region{
-        .bufferOffset = 0,
-        .bufferRowLength = 0,
-        .bufferImageHeight = 0,
-        .imageSubresource{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                          .mipLevel = 0,
-                          .baseArrayLayer = 0,
-                          .layerCount = 1},
-        .imageOffset{0, 0, 0},
-        .imageExtent{width, height, 1}};
-
-    vkCmdCopyBufferToImage(command_buffer, buffer, image,
-                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-    end_single_commands(command_buffer, transfer_command_pool);
-}
 void VulkanApplication::create_texture_image_view() {
-    texture_image_view =
-        create_image_view(texture_image, VK_FORMAT_R8G8B8A8_SRGB);
+    CPU_ZONE_FUNCTION();
+    texture_image_view = create_image_view(
+        texture_image, VK_FORMAT_R8G8B8A8_SRGB, texture_mip_levels);
 }
 
 VkImageView VulkanApplication::create_image_view(VkImage image,
-                                                 VkFormat format) {
+                                                 VkFormat format,
+                                                 uint32_t mip_levels) {
     VkImageViewCreateInfo create_info{
         .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
         .image = image,
@@ -1623,7 +3023,7 @@ VkImageView VulkanApplication::create_image_view(VkImage image,
         .subresourceRange{// image purpose and mipmap level
                           .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
                           .baseMipLevel = 0,
-                          .levelCount = 1,
+                          .levelCount = mip_levels,
                           .baseArrayLayer = 0,
                           .layerCount = 1}};
     VkImageView image_view;
@@ -1635,6 +3035,7 @@ VkImageView VulkanApplication::create_image_view(VkImage image,
 }
 
 void VulkanApplication::create_texture_sampler() {
+    CPU_ZONE_FUNCTION();
     VkPhysicalDeviceProperties properties{};
     vkGetPhysicalDeviceProperties(physical_device, &properties);
 
@@ -1652,7 +3053,7 @@ void VulkanApplication::create_texture_sampler() {
         .compareEnable = VK_FALSE,  // mainly for PCF
         .compareOp = VK_COMPARE_OP_ALWAYS,
         .minLod = 0.0f,
-        .maxLod = 0.0f,
+        .maxLod = VK_LOD_CLAMP_NONE,  // every level the view exposes
         .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
         .unnormalizedCoordinates = VK_FALSE};
 
@@ -11,57 +11,49 @@
 #include <Eigen/Core>
 #include <array>
 #include <optional>
+#include <string>
 #include <vector>
 
-typedef struct Vertex {
-    using Vec2f = Eigen::Vector2f;
-    using Vec3f = Eigen::Vector3f;
-    Vec2f pos;
-    Vec3f color;
-    Vec2f tex_coord;
-
-    // A vertex binding describes at which rate to load data from memory
-    // throughout the vertices.
-    static VkVertexInputBindingDescription get_binding_description() {
-        VkVertexInputBindingDescription binding_description{
-            .binding = 0,
-            .stride = sizeof(Vertex),
-            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX};
-        return binding_description;
-    }
-
-    static auto get_attribute_descriptions() {
-        std::array<VkVertexInputAttributeDescription, 3>
-            attribute_descriptions = {
-                VkVertexInputAttributeDescription{
-                    .location = 0,  // location in vertex shader input
-                    .binding = 0,
-                    .format = VK_FORMAT_R32G32_SFLOAT,  // vec2
-                    .offset =
-                        (uint32_t)offsetof(Vertex, pos)  // wtf, it exists?
-                },
-                VkVertexInputAttributeDescription{
-                    .location = 1,
-                    .binding = 0,
-                    .format = VK_FORMAT_R32G32B32_SFLOAT,  // vec3
-                    .offset = (uint32_t)offsetof(Vertex, color)},
-                VkVertexInputAttributeDescription{
-                    .location = 2,
-                    .binding = 0,
-                    .format = VK_FORMAT_R32G32_SFLOAT,  // vec2
-                    .offset = (uint32_t)offsetof(Vertex, tex_coord)}};
-
-        return attribute_descriptions;
-    }
-
-} Vertex;
+#include "asset_pack.h"
+#include "command_recycler.h"
+#include "deletion_queue.h"
+#include "frame_stats.h"
+#include "frustum_culler.h"
+#include "gpu_profiler.h"
+#include "mesh_registry.h"
+#include "pipeline_cache.h"
+#include "staging_uploader.h"
+#include "texture_streamer.h"
+#include "thread_pool.h"
+#include "vulkan_allocator.h"
 
+// the model matrix comes per draw or per instance, see DrawConstants
 typedef struct UniformBufferObject {
-    Eigen::Matrix4f model;
     Eigen::Matrix4f view;
     Eigen::Matrix4f project;
 } UniformBufferObject;
 
+// push constants of shaders/shader.vert, one set per draw in per-object mode
+typedef struct DrawConstants {
+    Eigen::Matrix4f model;
+    uint32_t material;  // index into the tint palette of the shader
+} DrawConstants;
+
+// push constants of shaders/cull.comp
+typedef struct CullParams {
+    Eigen::Vector4f planes[6];  // EigenHelper::frustum_planes
+    uint32_t command_count;
+    uint32_t batch_split;  // first command of the second IndirectBatch
+    uint32_t compact;      // 0 zeroes instanceCount instead of compacting
+} CullParams;
+
+// what the culling pass let through, summed over frames
+typedef struct CullStats {
+    uint64_t frames{0};
+    uint64_t visible_objects{0};
+    uint64_t visible_triangles{0};
+} CullStats;
+
 typedef struct QueueFamilyIndices {
     std::optional<uint32_t> graphics_family;
     std::optional<uint32_t> transfer_family;
@@ -78,21 +70,90 @@ typedef struct SwapChainSupportDetails {
     std::vector<VkPresentModeKHR> present_modes;
 } SwapChainSupportDetails;
 
+typedef enum RenderMode {
+    RENDER_MODE_PER_OBJECT,  // one draw per object, push constant transforms
+    RENDER_MODE_INSTANCED,   // one draw per mesh, transforms in binding 1
+    // GPU resident draw commands, transforms in a storage buffer
+    RENDER_MODE_INDIRECT,
+} RenderMode;
+
+// command line configurable settings
+typedef struct AppOptions {
+    uint32_t frames_in_flight{2};  // 1 .. MAX_FRAMES_IN_FLIGHT
+    uint32_t object_count{1};      // quads drawn each frame
+    uint32_t record_threads{0};    // 0 records inline on the main thread
+    bool record_benchmark{false};  // time recording over 1..N threads once
+    bool headless{false};          // offscreen targets, no SDL or surface
+    uint32_t frame_limit{0};       // exit after this many frames, 0 = never
+    bool benchmark{false};         // warm up, then time benchmark_frames
+    uint32_t warmup_frames{60};
+    uint32_t benchmark_frames{600};
+    std::string report_path;  // .json or .csv, empty prints only
+    std::string gpu_trace_path;  // Chrome trace JSON of GPU zones
+    std::string trace_path;      // Chrome trace JSON of CPU zones
+    bool serial_init{false};     // run the init graph on the main thread
+    // how texture mip chains are built, blit falls back to cpu when the
+    // format cannot be linearly blitted
+    MipGeneration mip_generation{MIP_GENERATION_BLIT};
+    // streamed texture, .ktx2 files are uploaded block compressed as stored
+    std::string texture_path{"textures/texture.jpg"};
+    // mapped archive consulted before loose files, see tools/asset_packer
+    std::string asset_pack_path;
+    // OBJ files (or pack entries) drawn round robin instead of the quad
+    std::vector<std::string> mesh_paths;
+    RenderMode render_mode{RENDER_MODE_PER_OBJECT};
+    bool gpu_culling{false};  // compute frustum culling, indirect mode only
+    bool cpu_culling{false};  // SIMD sphere culling, per-object mode only
+    float scene_spread{1.0f};  // grid extent multiplier, > 1 leaves the view
+} AppOptions;
+
+typedef struct SceneObject {
+    uint32_t mesh;          // MeshRegistry id
+    Eigen::Vector3f pivot;  // mesh bounding sphere center, rotated about
+    Eigen::Vector3f position;
+    float scale;  // fits the mesh bounding sphere to the grid cell
+    float spin;  // degrees per second around z
+} SceneObject;
+
+// consecutive instances of one mesh, drawn with a single vkCmdDrawIndexed
+typedef struct InstanceBatch {
+    uint32_t mesh;
+    uint32_t first_instance;
+    uint32_t instance_count;
+} InstanceBatch;
+
+// indirect commands sharing an index type, vkCmdDrawIndexedIndirect can not
+// switch index buffers between the draws it issues
+typedef struct IndirectBatch {
+    VkIndexType index_type;
+    uint32_t first_command;
+    uint32_t command_count;
+} IndirectBatch;
+
 class VulkanApplication {
    public:
+    static const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+    explicit VulkanApplication(AppOptions const &options = {});
     void run();
 
     std::vector<Vertex> vertices = {
-        {{-0.5f, -0.5f}, {1.0f, 1.0f, 1.0f}, {1.0f, 0.0f}},
-        {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
-        {{0.5f, 0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
-        {{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+        {{-0.5f, -0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 0.0f}},
+        {{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
+        {{0.5f, 0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
+        {{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
     };
 
-    std::vector<uint16_t> indices = {0, 1, 2, 2, 3, 0};
+    std::vector<uint32_t> indices = {0, 1, 2, 2, 3, 0};
 
    private:
-    static const int MAX_FRAMES_IN_FLIGHT = 2;
+    uint32_t frames_in_flight{2};
+    // widest point of the init graph, more threads would only idle
+    static constexpr uint32_t MAX_INIT_THREADS = 6;
+    static constexpr uint32_t TEXTURE_DECODE_THREADS = 2;
+    // pack entry replacing the built-in vertices/indices, always mesh 0
+    static constexpr char const *MESH_ASSET = "mesh/quad";
+    AppOptions options;
     SDL_Window *window = nullptr;
     int width = 800;
     int height = 600;
@@ -119,7 +180,7 @@ class VulkanApplication {
     VkPhysicalDevice physical_device{VK_NULL_HANDLE};
     VkDevice device;
     VkQueue graphics_queue;
-    VkQueue transfer_queue;
+    VkQueue transfer_queue;  // uploads, a second graphics queue if available
     VkQueue present_queue;
     VkSurfaceKHR surface;
     VkSwapchainKHR swapchain;
@@ -128,6 +189,8 @@ class VulkanApplication {
     VkExtent2D swapchain_extent;
     // using an image as a texture
     std::vector<VkImageView> swapchain_image_views;
+    // headless only: backing memory of the offscreen swapchain_images
+    std::vector<Allocation> offscreen_allocations;
     VkRenderPass render_pass;
     VkDescriptorSetLayout descriptor_set_layout;
     // alloc descriptor_sets in the pool
@@ -136,27 +199,141 @@ class VulkanApplication {
     VkPipelineLayout pipeline_layout;
     VkPipeline graphics_pipeline;
     std::vector<VkFramebuffer> swapchain_framebuffers;
-    VkCommandPool command_pool;
-    VkCommandPool transfer_command_pool;
+    std::vector<VkCommandPool> frame_command_pools;  // one per frame slot
     std::vector<VkCommandBuffer> command_buffers;
-    std::vector<VkSemaphore> image_available_semaphores;
-    std::vector<VkSemaphore> render_finished_semaphores;
-    std::vector<VkFence> in_flight_fences;
+    // recycled one-time-submit buffers on the graphics queue
+    CommandRecycler one_time_commands;
+    std::vector<VkSemaphore> image_available_semaphores;  // per frame slot
+    std::vector<VkSemaphore> render_finished_semaphores;  // per swapchain image
+    // single GPU counter, frame N signals N; uploads, deletion and readback
+    // all key off it
+    VkSemaphore frame_timeline{VK_NULL_HANDLE};
+    uint64_t frame_count{0};      // frames submitted so far
+    uint64_t completed_frame{0};  // newest frame known to be finished
+    double frame_wait_ms{0.0};    // host time blocked on frame_timeline
+    double frame_time_ms{0.0};    // host time spent in draw_frame
+    FrameTimes frame_times{};     // phase breakdown of the last draw_frame
+    FrameStats frame_stats;       // benchmark samples after warm-up
+    // timestamp zones per frame slot and per upload batch
+    bool host_query_reset{false};
+    GpuProfiler frame_profiler;
+    GpuProfiler upload_profiler;
+    // objects replaced at runtime, freed once completed_frame passes them
+    DeletionQueue deletion_queue;
     uint32_t current_frame{0};
     bool framebuffer_resized{false};
-    bool window_minimized{true};
+    bool window_minimized{false};
 
+    // every VkBuffer/VkImage is placed inside allocator owned memory blocks
+    DeviceAllocator allocator;
+    // batches all host -> device copies into one transfer submission
+    StagingUploader staging_uploader;
+    uint64_t upload_ticket{0};  // last upload batch the frames depend on
+    // shared by every pipeline creation, loaded from and saved to disk
+    PipelineCache pipeline_cache;
+    // time spent in vkCreate*Pipelines, one per init step since the two
+    // pipelines are created concurrently
+    double graphics_compile_ms{0.0};
+    double cull_compile_ms{0.0};
+
+    // every mesh lives in these two buffers, see MeshRegistry
+    MeshRegistry meshes;
     VkBuffer vertex_buffer;
-    VkDeviceMemory vertex_buffer_memory;  // __DEVICE__
+    Allocation vertex_buffer_allocation;  // __DEVICE__
     VkBuffer index_buffer;
-    VkDeviceMemory index_buffer_memory;
-    std::vector<VkBuffer> uniform_buffers;
-    std::vector<VkDeviceMemory> uniform_buffers_memory;
+    Allocation index_buffer_allocation;
+    // one persistently mapped UniformBufferObject (view and projection) per
+    // frame in flight, selected with a dynamic offset
+    VkBuffer uniform_buffer;
+    Allocation uniform_buffer_allocation;
+    char *uniform_mapped{nullptr};
+    VkDeviceSize uniform_stride{0};  // sizeof(UBO) padded to the min alignment
+    uint32_t uniform_offset{0};      // dynamic offset of the current frame
+    // per-object mode: what each draw pushes, filled before recording
+    std::vector<DrawConstants> draw_constants;
+
+    std::vector<SceneObject> scene_objects;
+    uint64_t triangles_per_frame{0};
+    uint32_t draws_per_frame{0};  // vkCmdDrawIndexed calls per frame
+
+    // instanced and indirect modes: per-instance data grouped by mesh, one
+    // persistently mapped slice per frame in flight, bound at vertex
+    // binding 1 or as the storage buffer at descriptor binding 2
+    std::vector<InstanceBatch> instance_batches;
+    std::vector<uint32_t> instance_slots;  // scene object -> instance index
+    VkBuffer instance_buffer{VK_NULL_HANDLE};
+    Allocation instance_buffer_allocation;
+    char *instance_mapped{nullptr};
+    VkDeviceSize instance_slice{0};  // bytes per frame, offset aligned
 
+    // indirect mode: one VkDrawIndexedIndirectCommand per object, uploaded
+    // once, plus the draw count of every batch for the *IndirectCount draw
+    std::vector<IndirectBatch> indirect_batches;
+    VkBuffer indirect_buffer{VK_NULL_HANDLE};
+    Allocation indirect_buffer_allocation;
+    VkBuffer indirect_count_buffer{VK_NULL_HANDLE};
+    Allocation indirect_count_buffer_allocation;
+    // optional device features, without them every command is its own draw
+    bool multi_draw_indirect{false};
+    bool draw_indirect_first_instance{false};
+    bool draw_indirect_count{false};
+    uint32_t max_draw_indirect_count{1};
+    // every batch fits one vkCmdDrawIndexedIndirectCount
+    bool indirect_count_draws{false};
+
+    // gpu culling: cull.comp writes the surviving commands of a frame into
+    // its slice of visible_buffer and their counts into cull_count_buffer
+    VkDescriptorSetLayout cull_set_layout{VK_NULL_HANDLE};
+    VkPipelineLayout cull_pipeline_layout{VK_NULL_HANDLE};
+    VkPipeline cull_pipeline{VK_NULL_HANDLE};
+    VkDescriptorPool cull_descriptor_pool{VK_NULL_HANDLE};
+    std::vector<VkDescriptorSet> cull_descriptor_sets;  // per frame slot
+    VkBuffer cull_sphere_buffer{VK_NULL_HANDLE};  // per command, mesh space
+    Allocation cull_sphere_buffer_allocation;
+    VkBuffer visible_buffer{VK_NULL_HANDLE};
+    Allocation visible_buffer_allocation;
+    VkDeviceSize visible_slice{0};
+    // host visible, read back and zeroed once the slot's frame finished
+    VkBuffer cull_count_buffer{VK_NULL_HANDLE};
+    Allocation cull_count_buffer_allocation;
+    char *cull_count_mapped{nullptr};
+    VkDeviceSize cull_count_slice{0};
+    CullParams cull_params{};
+    CullStats cull_stats;
+
+    // cpu culling: world space bounding spheres of the scene objects, culled
+    // every frame into the list of objects that get drawn
+    FrustumCuller cpu_culler;
+    std::vector<uint32_t> draw_objects;  // draw -> scene object
+    double cull_time_ms{0.0};            // host time spent culling
+
+    // multithreaded recording, one pool and secondary per (frame, job)
+    ThreadPool record_workers;
+    uint32_t record_jobs{0};  // 0 records inline into the primary
+    uint32_t max_record_jobs{0};
+    std::vector<VkCommandPool> secondary_command_pools;
+    std::vector<VkCommandBuffer> secondary_command_buffers;
+    double record_time_ms{0.0};  // host time spent recording draws
+
+    // placeholder bound until the streamed texture is resident
     VkImage texture_image;
     VkImageView texture_image_view;
     VkSampler texture_sampler;
-    VkDeviceMemory texture_image_memory;
+    Allocation texture_image_allocation;
+    uint32_t texture_mip_levels{1};
+    TextureStreamer texture_streamer;
+    uint32_t streamed_texture{UINT32_MAX};
+    std::vector<VkImageView> bound_texture_views;  // per frame slot
+
+    // read off the critical path before the device exists, the views point
+    // either into the *_code vectors or into the mapped asset pack
+    AssetPack asset_pack;
+    std::vector<char> vert_shader_code;
+    std::vector<char> frag_shader_code;
+    std::vector<char> cull_shader_code;
+    AssetView vert_shader;
+    AssetView frag_shader;
+    AssetView cull_shader;
 
     void init_window();
     void init_vulkan();
@@ -185,52 +362,74 @@ class VulkanApplication {
         const std::vector<VkPresentModeKHR> &availabla_present_modes);
     VkExtent2D choose_swap_extent(const VkSurfaceCapabilitiesKHR &capabilities);
 
-    void create_swapchain();
-    VkImageView create_image_view(VkImage image, VkFormat format);
+    // returns false (and keeps the current swapchain) when minimized
+    bool create_swapchain(VkSwapchainKHR old_swapchain = VK_NULL_HANDLE);
+    VkImageView create_image_view(VkImage image, VkFormat format,
+                                  uint32_t mip_levels = 1);
+    void create_offscreen_targets();
     void create_image_views();
     void create_render_pass();
-    VkShaderModule create_shader_module(std::vector<char> const &code);
+    VkShaderModule create_shader_module(AssetView const &code);
 
     void create_descriptor_set_layout();
     void create_graphics_pipeline();
+    void create_cull_pipeline();
     void create_framebuffers();
     void create_command_pool();
+    void create_staging_uploader();
     // buffer creation helper
     void create_buffer(VkDeviceSize size, VkBufferUsageFlags usage,
                        VkMemoryPropertyFlags properties, VkBuffer &buffer,
-                       VkDeviceMemory &buffer_memory);
-    void copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer,
-                     VkDeviceSize size);
-    void copy_buffer2image(VkBuffer buffer, VkImage image, uint32_t width,
-                           uint32_t height);
-    void create_image(uint32_t width, uint32_t height, VkFormat format,
-                      VkImageTiling tiling, VkImageUsageFlags usage,
+                       Allocation &buffer_allocation);
+    void destroy_buffer(VkBuffer &buffer, Allocation &buffer_allocation);
+    void create_image(uint32_t width, uint32_t height, uint32_t mip_levels,
+                      VkFormat format, VkImageTiling tiling,
+                      VkImageUsageFlags usage,
                       VkMemoryPropertyFlags properties, VkImage &image,
-                      VkDeviceMemory &image_memory);
-    void transition_image_layout(VkImage image, VkFormat format,
-                                 VkImageLayout old_layout,
-                                 VkImageLayout new_layout);
+                      Allocation &image_allocation);
+    void destroy_image(VkImage &image, Allocation &image_allocation);
+    void open_asset_pack();
+    void load_shaders();
     void create_texture_image();
+    void create_texture_streamer();
+    void bind_texture(uint32_t slot);
     void create_texture_image_view();
     void create_texture_sampler();
-    void create_vertex_buffer();
-    void create_index_buffer();
+    void load_meshes();
+    void create_mesh_buffers();
     void create_uniform_buffers();
+    void create_instance_buffer();
+    void create_indirect_buffers();
+    void create_cull_buffers();
+    void create_cull_descriptor_sets();
+    void collect_cull_counts(uint32_t slot);
     void create_descriptor_pool();
     void create_descriptor_sets();
     void update_uniform_buffer(uint32_t current_image);
     void create_command_buffer();
     void record_command_buffer(VkCommandBuffer command_buffer,
                                uint32_t image_index);
+    void record_draws(VkCommandBuffer command_buffer, uint32_t first,
+                      uint32_t count);
+    void record_instanced(VkCommandBuffer command_buffer);
+    void record_indirect(VkCommandBuffer command_buffer);
+    void record_culling(VkCommandBuffer command_buffer);
+    void record_secondary(uint32_t job, uint32_t image_index);
+    void create_secondary_command_buffers();
+    void benchmark_recording();
+    void create_scene();
     void create_sync_objects();
+    void create_present_semaphores();
+    uint64_t poll_completed_frame();
+    void wait_for_frame(uint64_t frame);
     void cleanup_swapchain();
+    void cleanup_pipeline();
     void recreate_swapchain();
+    // destroy after every frame submitted so far has finished
+    void retire_buffer(VkBuffer &buffer, Allocation &buffer_allocation);
+    void retire_image(VkImage &image, Allocation &image_allocation);
     void create_instance();
 
-    VkCommandBuffer begin_single_commands(VkCommandPool command_pool);
-    void end_single_commands(VkCommandBuffer command_buffer,
-                             VkCommandPool command_pool);
-
     void main_loop();
     void draw_frame();
     void cleanup();
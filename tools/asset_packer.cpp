@@ -0,0 +1,246 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#define STB_IMAGE_IMPLEMENTATION
+#include "../external/stb_image.h"
+#include "../src/asset_pack.h"
+#include "../src/image_util.h"
+#include "../src/ktx2.h"
+#include "../src/obj_loader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Builds the archive the app opens with --assets. Entries are named after
+// the relative path the app would otherwise open, so a pack simply overlays
+// the loose files. --bench times both load paths for the same entries.
+
+// mirrors VulkanApplication::vertices/indices
+static const Vertex QUAD_VERTICES[4] = {
+    {{-0.5f, -0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 0.0f}},
+    {{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
+    {{0.5f, 0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
+    {{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+};
+static const uint16_t QUAD_INDICES[6] = {0, 1, 2, 2, 3, 0};
+
+static void print_usage(char const* program) {
+    std::cerr << "usage: " << program << " OUTPUT.pack FILE... [--no-quad]\n"
+              << "       " << program << " --bench PACK [--iterations N]\n";
+}
+
+static bool ends_with(std::string const& s, char const* suffix) {
+    auto n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static std::vector<unsigned char> read_bytes(std::string const& path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open file! " + path);
+    }
+    std::vector<unsigned char> buffer((size_t)file.tellg());
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    return buffer;
+}
+
+// same index width rule as MeshRegistry: 16-bit up to 65536 vertices
+static PackBlob pack_mesh(std::string const& path) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    load_obj(path, vertices, indices);
+    if (vertices.size() > 65536) {
+        return make_mesh_blob(path, vertices.data(), (uint32_t)vertices.size(),
+                              sizeof(Vertex), indices.data(),
+                              (uint32_t)indices.size(), sizeof(uint32_t));
+    }
+    std::vector<uint16_t> narrow(indices.begin(), indices.end());
+    return make_mesh_blob(path, vertices.data(), (uint32_t)vertices.size(),
+                          sizeof(Vertex), narrow.data(),
+                          (uint32_t)narrow.size(), sizeof(uint16_t));
+}
+
+// textures are stored in upload layout: full mip chain, largest first
+static PackBlob pack_texture(std::string const& path) {
+    if (ends_with(path, ".ktx2")) {
+        auto image = load_ktx2(path);
+        TextureBlob header{.format = (uint32_t)image.format,
+                           .width = image.width,
+                           .height = image.height,
+                           .mip_levels = image.mip_levels,
+                           .block_extent = image.block_extent,
+                           .block_bytes = image.block_bytes};
+        return make_texture_blob(path, header, image.data.data(),
+                                 image.data.size());
+    }
+    int width, height, channels;
+    auto pixels =
+        stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels) {
+        throw std::runtime_error("failed to load texture image! " + path);
+    }
+    TextureBlob header{.format = VK_FORMAT_R8G8B8A8_SRGB,
+                       .width = (uint32_t)width,
+                       .height = (uint32_t)height,
+                       .mip_levels = mip_level_count(width, height),
+                       .block_extent = 1,
+                       .block_bytes = 4};
+    auto chain = build_mip_chain_rgba8(pixels, header.width, header.height,
+                                       header.mip_levels, true);
+    stbi_image_free(pixels);
+    return make_texture_blob(path, header, chain.data(), chain.size());
+}
+
+static int pack(std::string const& output,
+                std::vector<std::string> const& inputs, bool quad) {
+    std::vector<PackBlob> blobs;
+    if (quad) {
+        blobs.push_back(make_mesh_blob("mesh/quad", QUAD_VERTICES, 4,
+                                       sizeof(Vertex), QUAD_INDICES, 6,
+                                       sizeof(QUAD_INDICES[0])));
+    }
+    for (auto const& input : inputs) {
+        if (ends_with(input, ".spv")) {
+            blobs.push_back(
+                PackBlob{.name = input, .type = ASSET_SHADER,
+                         .data = read_bytes(input)});
+        } else if (ends_with(input, ".obj")) {
+            blobs.push_back(pack_mesh(input));
+        } else {
+            blobs.push_back(pack_texture(input));
+        }
+    }
+    write_asset_pack(output, blobs);
+
+    uint64_t total = 0;
+    for (auto const& blob : blobs) {
+        total += blob.data.size();
+        std::cout << "  " << blob.name << ": " << blob.data.size() / 1024.0
+                  << " KiB\n";
+    }
+    std::cout << output << ": " << blobs.size() << " entries, "
+              << total / (1024.0 * 1024.0) << " MiB\n";
+    return EXIT_SUCCESS;
+}
+
+// per file: what the app does without a pack (ifstream / stbi / KTX2 read),
+// pack: mmap once and memcpy every blob, both into the same "staging" buffer
+static int bench(std::string const& path, uint32_t iterations) {
+    std::vector<PackEntry> entries;
+    {
+        AssetPack probe;
+        probe.open(path);
+        entries = probe.entries();
+    }
+    std::vector<unsigned char> staging;
+    auto stage = [&](void const* data, size_t size) {
+        if (staging.size() < size) {
+            staging.resize(size);
+        }
+        memcpy(staging.data(), data, size);
+        return (uint64_t)size;
+    };
+    auto elapsed_ms = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+            .count();
+    };
+
+    double file_ms = 0.0, pack_ms = 0.0;
+    uint64_t file_bytes = 0, pack_bytes = 0;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        for (auto const& entry : entries) {
+            std::string name = entry.name;
+            if (entry.type == ASSET_SHADER) {
+                auto code = read_bytes(name);
+                file_bytes += stage(code.data(), code.size());
+            } else if (entry.type == ASSET_MESH && ends_with(name, ".obj")) {
+                std::vector<Vertex> vertices;
+                std::vector<uint32_t> indices;
+                load_obj(name, vertices, indices);
+                file_bytes += stage(vertices.data(),
+                                    vertices.size() * sizeof(Vertex));
+                file_bytes += stage(indices.data(),
+                                    indices.size() * sizeof(uint32_t));
+            } else if (entry.type == ASSET_TEXTURE &&
+                       ends_with(name, ".ktx2")) {
+                auto image = load_ktx2(name);
+                file_bytes += stage(image.data.data(), image.data.size());
+            } else if (entry.type == ASSET_TEXTURE) {
+                int width, height, channels;
+                auto pixels = stbi_load(name.c_str(), &width, &height,
+                                        &channels, STBI_rgb_alpha);
+                if (!pixels) {
+                    throw std::runtime_error("failed to load texture image! " +
+                                             name);
+                }
+                file_bytes += stage(pixels, (size_t)width * height * 4);
+                stbi_image_free(pixels);
+            }
+        }
+        file_ms += elapsed_ms(start);
+
+        start = std::chrono::steady_clock::now();
+        AssetPack asset_pack;
+        asset_pack.open(path);
+        for (auto const& entry : asset_pack.entries()) {
+            auto view = asset_pack.find(entry.name, (AssetType)entry.type);
+            pack_bytes += stage(view.data, view.size);
+        }
+        asset_pack.close();
+        pack_ms += elapsed_ms(start);
+    }
+
+    auto report = [&](char const* label, double ms, uint64_t bytes) {
+        std::cout << label << ms / iterations << " ms/load, "
+                  << bytes / (1024.0 * 1024.0) / (ms / 1000.0) << " MiB/s\n";
+    };
+    std::cout << entries.size() << " entries, " << iterations
+              << " iterations (warm page cache)\n";
+    report("  per file: ", file_ms, file_bytes);
+    report("  mmap pack: ", pack_ms, pack_bytes);
+    std::cout << "  speedup: " << file_ms / std::max(pack_ms, 1e-6) << "x\n";
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    try {
+        if (std::strcmp(argv[1], "--bench") == 0) {
+            uint32_t iterations = 10;
+            for (int i = 3; i < argc; ++i) {
+                if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+                    iterations = std::max(std::stoi(argv[++i]), 1);
+                } else {
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            }
+            return bench(argv[2], iterations);
+        }
+        std::vector<std::string> inputs;
+        bool quad = true;
+        for (int i = 2; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--no-quad") == 0) {
+                quad = false;
+            } else {
+                inputs.push_back(argv[i]);
+            }
+        }
+        return pack(argv[1], inputs, quad);
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,176 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "bc7_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const uint32_t WEIGHTS4[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                      34, 38, 43, 47, 51, 55, 60, 64};
+
+typedef struct Mode6 {
+    uint32_t endpoint[2][4];  // 7 bit per channel
+    uint32_t pbit[2];
+    uint32_t index[16];
+    uint64_t error;
+} Mode6;
+
+static uint32_t quantize(float value, uint32_t pbit) {
+    auto q = std::lround((value - (float)pbit) / 2.0f);
+    return (uint32_t)std::clamp(q, 0l, 127l);
+}
+
+// picks the closest palette entry per pixel for fixed endpoints
+static void assign_indices(unsigned char const *rgba, Mode6 &mode) {
+    uint32_t palette[16][4];
+    for (uint32_t i = 0; i < 16; ++i) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            auto e0 = (mode.endpoint[0][c] << 1) | mode.pbit[0];
+            auto e1 = (mode.endpoint[1][c] << 1) | mode.pbit[1];
+            palette[i][c] =
+                ((64 - WEIGHTS4[i]) * e0 + WEIGHTS4[i] * e1 + 32) >> 6;
+        }
+    }
+    mode.error = 0;
+    for (uint32_t p = 0; p < 16; ++p) {
+        uint64_t best_error = UINT64_MAX;
+        for (uint32_t i = 0; i < 16; ++i) {
+            uint64_t error = 0;
+            for (uint32_t c = 0; c < 4; ++c) {
+                int d = (int)rgba[p * 4 + c] - (int)palette[i][c];
+                error += (uint64_t)(d * d);
+            }
+            if (error < best_error) {
+                best_error = error;
+                mode.index[p] = i;
+            }
+        }
+        mode.error += best_error;
+    }
+}
+
+static void write_bits(unsigned char out[16], uint32_t &bit, uint32_t value,
+                       uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i, ++bit) {
+        if ((value >> i) & 1) {
+            out[bit / 8] |= (unsigned char)(1u << (bit % 8));
+        }
+    }
+}
+
+uint64_t encode_bc7_block(unsigned char const *rgba, unsigned char out[16]) {
+    // principal axis of the 16 RGBA points by power iteration
+    float mean[4] = {0, 0, 0, 0};
+    for (uint32_t p = 0; p < 16; ++p) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            mean[c] += rgba[p * 4 + c] / 16.0f;
+        }
+    }
+    float covariance[4][4] = {};
+    for (uint32_t p = 0; p < 16; ++p) {
+        for (uint32_t i = 0; i < 4; ++i) {
+            for (uint32_t j = 0; j < 4; ++j) {
+                covariance[i][j] += (rgba[p * 4 + i] - mean[i]) *
+                                    (rgba[p * 4 + j] - mean[j]);
+            }
+        }
+    }
+    float axis[4] = {1, 1, 1, 1};
+    for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {0, 0, 0, 0};
+        for (uint32_t i = 0; i < 4; ++i) {
+            for (uint32_t j = 0; j < 4; ++j) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+        }
+        float length = std::sqrt(next[0] * next[0] + next[1] * next[1] +
+                                 next[2] * next[2] + next[3] * next[3]);
+        if (length < 1e-6f) {
+            break;  // flat block, any axis works
+        }
+        for (uint32_t i = 0; i < 4; ++i) {
+            axis[i] = next[i] / length;
+        }
+    }
+
+    float t_min = 0.0f, t_max = 0.0f;
+    for (uint32_t p = 0; p < 16; ++p) {
+        float t = 0.0f;
+        for (uint32_t c = 0; c < 4; ++c) {
+            t += (rgba[p * 4 + c] - mean[c]) * axis[c];
+        }
+        t_min = std::min(t_min, t);
+        t_max = std::max(t_max, t);
+    }
+
+    Mode6 best{};
+    best.error = UINT64_MAX;
+    for (uint32_t pbits = 0; pbits < 4; ++pbits) {
+        Mode6 mode{};
+        mode.pbit[0] = pbits & 1;
+        mode.pbit[1] = pbits >> 1;
+        for (uint32_t c = 0; c < 4; ++c) {
+            mode.endpoint[0][c] =
+                quantize(mean[c] + t_min * axis[c], mode.pbit[0]);
+            mode.endpoint[1][c] =
+                quantize(mean[c] + t_max * axis[c], mode.pbit[1]);
+        }
+        assign_indices(rgba, mode);
+        if (mode.error < best.error) {
+            best = mode;
+        }
+    }
+
+    // the anchor (pixel 0) index is stored with an implicit zero high bit
+    if (best.index[0] >= 8) {
+        std::swap(best.endpoint[0], best.endpoint[1]);
+        std::swap(best.pbit[0], best.pbit[1]);
+        for (auto &index : best.index) {
+            index = 15 - index;
+        }
+    }
+
+    memset(out, 0, 16);
+    uint32_t bit = 0;
+    write_bits(out, bit, 1u << 6, 7);  // mode 6
+    for (uint32_t c = 0; c < 4; ++c) {
+        write_bits(out, bit, best.endpoint[0][c], 7);
+        write_bits(out, bit, best.endpoint[1][c], 7);
+    }
+    write_bits(out, bit, best.pbit[0], 1);
+    write_bits(out, bit, best.pbit[1], 1);
+    write_bits(out, bit, best.index[0], 3);
+    for (uint32_t p = 1; p < 16; ++p) {
+        write_bits(out, bit, best.index[p], 4);
+    }
+    return best.error;
+}
+
+std::vector<unsigned char> encode_bc7_image(unsigned char const *pixels,
+                                            uint32_t width, uint32_t height,
+                                            uint64_t &squared_error) {
+    uint32_t blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    std::vector<unsigned char> blocks((size_t)blocks_x * blocks_y * 16);
+    for (uint32_t by = 0; by < blocks_y; ++by) {
+        for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+            unsigned char rgba[64];
+            for (uint32_t y = 0; y < 4; ++y) {
+                for (uint32_t x = 0; x < 4; ++x) {
+                    auto sx = std::min(bx * 4 + x, width - 1);
+                    auto sy = std::min(by * 4 + y, height - 1);
+                    memcpy(rgba + (y * 4 + x) * 4,
+                           pixels + ((size_t)sy * width + sx) * 4, 4);
+                }
+            }
+            auto error = encode_bc7_block(
+                rgba, blocks.data() + ((size_t)by * blocks_x + bx) * 16);
+            // padded pixels duplicate real ones, only count full blocks
+            if (bx * 4 + 4 <= width && by * 4 + 4 <= height) {
+                squared_error += error;
+            }
+        }
+    }
+    return blocks;
+}
@@ -0,0 +1,24 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+
+#ifndef VK_TUTORIAL_BC7_ENCODER_H
+#define VK_TUTORIAL_BC7_ENCODER_H
+
+#include <cstdint>
+#include <vector>
+
+// Encodes one 4x4 RGBA8 block (64 bytes, row major) as BC7 mode 6: one
+// subset, 7 bit RGBA endpoints with a p-bit each, 4 bit indices. Endpoints
+// come from the principal axis of the block, every p-bit pair is tried.
+// Returns the summed squared error of the encoded block.
+uint64_t encode_bc7_block(unsigned char const *rgba, unsigned char out[16]);
+
+// Encodes a whole RGBA8 image, edge blocks are padded by clamping, returns
+// 16 bytes per 4x4 block. squared_error accumulates over the blocks that
+// lie fully inside the image.
+std::vector<unsigned char> encode_bc7_image(unsigned char const *pixels,
+                                            uint32_t width, uint32_t height,
+                                            uint64_t &squared_error);
+
+#endif  // VK_TUTORIAL_BC7_ENCODER_H
@@ -0,0 +1,121 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#include "../src/eigen_helper.hpp"
+#include "../src/frustum_culler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Times FrustumCuller over random spheres with every path the CPU supports,
+// on one thread and on a pool, and checks each result against the scalar
+// path. The camera is the one VulkanApplication uses, so about a third of
+// the spheres end up inside the frustum.
+
+static void print_usage(char const* program) {
+    std::cerr << "usage: " << program
+              << " [--objects N] [--iterations N] [--threads N]\n";
+}
+
+int main(int argc, char** argv) {
+    uint32_t object_count = 1u << 20;
+    uint32_t iterations = 50;
+    uint32_t thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    try {
+        for (int i = 1; i < argc; ++i) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (std::strcmp(argv[i], "--objects") == 0) {
+                object_count = (uint32_t)std::stoul(argv[++i]);
+            } else if (std::strcmp(argv[i], "--iterations") == 0) {
+                iterations = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+            } else if (std::strcmp(argv[i], "--threads") == 0) {
+                thread_count = (uint32_t)std::stoul(argv[++i]);
+            } else {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+
+        // spheres spread around the origin the camera looks at
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> position(-4.0f, 4.0f);
+        std::uniform_real_distribution<float> size(0.01f, 0.2f);
+        FrustumCuller culler;
+        culler.resize(object_count);
+        for (uint32_t i = 0; i < object_count; ++i) {
+            culler.set_sphere(
+                i, Eigen::Vector3f(position(rng), position(rng), position(rng)),
+                size(rng));
+        }
+
+        Eigen::Matrix4f view = EigenHelper::lookAt(
+            Eigen::Vector3f(2.0f, 2.0f, 2.0f), Eigen::Vector3f::Zero(),
+            Eigen::Vector3f(0.0f, 0.0f, 1.0f));
+        Eigen::Matrix4f project = EigenHelper::perspective(
+            EigenHelper::to_radian(45.0f), 16.0f / 9.0f, 0.1f, 10.0f);
+        project(1, 1) *= -1;
+        auto planes = EigenHelper::frustum_planes(project * view);
+
+        ThreadPool pool;
+        pool.init(thread_count);
+        std::vector<uint32_t> reference, visible;
+        culler.set_path(CULL_PATH_SCALAR);
+        culler.cull(planes, reference);
+
+        std::cout << object_count << " spheres, " << reference.size()
+                  << " visible, " << iterations << " iterations\n";
+        double scalar_ms = 0.0;
+        for (auto path : {CULL_PATH_SCALAR, CULL_PATH_SSE, CULL_PATH_AVX2}) {
+            if (!FrustumCuller::is_supported(path)) {
+                std::cout << "  " << FrustumCuller::path_name(path)
+                          << ": not supported\n";
+                continue;
+            }
+            culler.set_path(path);
+            for (auto* workers : {(ThreadPool*)nullptr, &pool}) {
+                if (workers && thread_count == 0) {
+                    continue;
+                }
+                culler.cull(planes, visible, workers);  // warm up
+                if (visible != reference) {
+                    throw std::runtime_error(
+                        std::string("mismatch against scalar on ") +
+                        FrustumCuller::path_name(path));
+                }
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t i = 0; i < iterations; ++i) {
+                    culler.cull(planes, visible, workers);
+                }
+                auto ms = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - start)
+                              .count() /
+                          iterations;
+                if (path == CULL_PATH_SCALAR && !workers) {
+                    scalar_ms = ms;
+                }
+                std::cout << "  " << FrustumCuller::path_name(path) << ", "
+                          << (workers ? std::to_string(thread_count) +
+                                            " workers"
+                                      : std::string("inline"))
+                          << ": " << ms << " ms, "
+                          << object_count / (ms * 1000.0)
+                          << " M objects/s, speedup " << scalar_ms / ms
+                          << "x\n";
+            }
+        }
+        pool.destroy();
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
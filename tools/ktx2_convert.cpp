@@ -0,0 +1,111 @@
+//
+// Created by undersilence on 2026/10/16.
+//
+#define STB_IMAGE_IMPLEMENTATION
+#include "../external/stb_image.h"
+#include "../src/image_util.h"
+#include "../src/ktx2.h"
+#include "bc7_encoder.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Offline converter for textures the app streams: decodes a JPG/PNG, builds
+// the box filtered mip chain and writes it as BC7 (or plain RGBA8) KTX2, so
+// the runtime only copies blocks instead of decoding and filtering.
+static void print_usage(char const* program) {
+    std::cerr << "usage: " << program
+              << " INPUT.jpg|png OUTPUT.ktx2 [--rgba8] [--linear]"
+                 " [--no-mips]\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::string input = argv[1], output = argv[2];
+    bool compress = true, srgb = true, mips = true;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--rgba8") == 0) {
+            compress = false;
+        } else if (std::strcmp(argv[i], "--linear") == 0) {
+            srgb = false;
+        } else if (std::strcmp(argv[i], "--no-mips") == 0) {
+            mips = false;
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        int width, height, channels;
+        auto pixels = stbi_load(input.c_str(), &width, &height, &channels,
+                                STBI_rgb_alpha);
+        if (!pixels) {
+            throw std::runtime_error("failed to load texture image! " + input);
+        }
+        Ktx2Image image{.width = (uint32_t)width,
+                        .height = (uint32_t)height,
+                        .mip_levels = mips ? mip_level_count(width, height)
+                                           : 1};
+        auto chain = build_mip_chain_rgba8(pixels, image.width, image.height,
+                                           image.mip_levels, srgb);
+        stbi_image_free(pixels);
+        auto rgba8_bytes = chain.size();
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t squared_error = 0, compared_pixels = 0;
+        if (compress) {
+            image.format =
+                srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+            size_t offset = 0;
+            for (uint32_t level = 0; level < image.mip_levels; ++level) {
+                auto w = std::max(image.width >> level, 1u);
+                auto h = std::max(image.height >> level, 1u);
+                uint64_t level_error = 0;
+                auto blocks =
+                    encode_bc7_image(chain.data() + offset, w, h, level_error);
+                image.data.insert(image.data.end(), blocks.begin(),
+                                  blocks.end());
+                if (level == 0) {
+                    squared_error = level_error;
+                    compared_pixels = (uint64_t)(w / 4) * (h / 4) * 16;
+                }
+                offset += (size_t)w * h * 4;
+            }
+        } else {
+            image.format =
+                srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+            image.data = std::move(chain);
+        }
+        ktx2_block_info(image.format, image.block_extent, image.block_bytes);
+        auto encode_ms = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        write_ktx2(output, image);
+
+        std::cout << input << ": " << image.width << "x" << image.height
+                  << ", " << image.mip_levels << " levels, "
+                  << rgba8_bytes / 1024.0 << " KiB as RGBA8 -> "
+                  << image.data.size() / 1024.0 << " KiB";
+        if (compress) {
+            auto mse = (double)squared_error /
+                       (double)std::max<uint64_t>(compared_pixels * 4, 1);
+            std::cout << " BC7 in " << encode_ms << " ms, level 0 PSNR "
+                      << (mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse)
+                                    : INFINITY)
+                      << " dB";
+        }
+        std::cout << '\n';
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}